@@ -0,0 +1,855 @@
+#pragma once
+
+#include <array>
+#include <bit>
+#include <cstdint>
+#include <initializer_list>
+#include "chess_rules/thc.h"
+#include "ChessBoardWeights.h"
+
+#if defined(__BMI2__)
+#include <immintrin.h>
+#endif
+
+// Attack sets of every piece for every square. Bit n of a bitboard is thc square n (a8 = 0, h1 = 63).
+// Sliding attacks are looked up by magic multiplication of relevant occupancy (PEXT when compiled with BMI2),
+// tables are filled once at program start.
+class BitboardAttacks {
+public:
+    using Bitboard = uint64_t;
+
+    // squares attacked by pawn of given colour standing on square
+    static Bitboard pawn(int square, bool white) {
+        return tables.pawn[white ? 0 : 1][square];
+    }
+
+    static Bitboard knight(int square) {
+        return tables.knight[square];
+    }
+
+    static Bitboard king(int square) {
+        return tables.king[square];
+    }
+
+    static Bitboard bishop(int square, Bitboard occupied) {
+        return tables.bishop[square].lookup(occupied);
+    }
+
+    static Bitboard rook(int square, Bitboard occupied) {
+        return tables.rook[square].lookup(occupied);
+    }
+
+    static Bitboard queen(int square, Bitboard occupied) {
+        return bishop(square, occupied) | rook(square, occupied);
+    }
+
+    // whole line (rank, file or diagonal) through both squares, empty when they are not on one line
+    static Bitboard line(int square1, int square2) {
+        return tables.line[square1][square2];
+    }
+
+    // squares strictly between two squares on one line
+    static Bitboard between(int square1, int square2) {
+        return tables.between[square1][square2];
+    }
+
+private:
+    using Directions = std::array<std::array<int, 2>, 4>; // {row, file} steps
+    constexpr static Directions bishopDirections{{{-1, -1}, {-1, 1}, {1, -1}, {1, 1}}};
+    constexpr static Directions rookDirections{{{-1, 0}, {1, 0}, {0, -1}, {0, 1}}};
+
+    // magic numbers for this square numbering, found by trying sparse random numbers until one maps every
+    // occupancy of the square without destructive collision
+    constexpr static std::array<Bitboard, 64> bishopMagics{
+            0x10102002004a1420ull, 0x8020040400584008ull, 0x10510800811201c8ull, 0x5204042080000088ull,
+            0x2204106880000002ull, 0x1401042004000000ull, 0x0400880410042004ull, 0x0028208200a02020ull,
+            0x1500241990010e00ull, 0x8001200182020a40ull, 0x40004101030b0000ull, 0x8002041042000100ull,
+            0x4010011041020038ull, 0x0000010421044000ull, 0x1500210808020a00ull, 0x8000088400880520ull,
+            0x0405004010040100ull, 0x1005823210040108ull, 0x2708008102040011ull, 0x4048200404009100ull,
+            0x0018104101400024ull, 0x0003000601190101ull, 0x8004803108491000ull, 0x8014241200820800ull,
+            0x0006e080100c3040ull, 0x0501044a11041800ull, 0x9020300008004045ull, 0x0894080000220040ull,
+            0x1001010083104000ull, 0x5004030040900080ull, 0x000400422c012400ull, 0x0002128698404812ull,
+            0x1010108404900440ull, 0x0928021182084100ull, 0x2006080409020024ull, 0x1010202020180080ull,
+            0xa010008200202200ull, 0x2098015100019004ull, 0x0002041440810811ull, 0x802a02020000b098ull,
+            0x0009015090004060ull, 0x4000821082081001ull, 0x0100210040420800ull, 0x0800004010488a00ull,
+            0x2000081104004040ull, 0x4c8e029015000082ull, 0x0420340322224842ull, 0x1298260043400210ull,
+            0x0000822802400008ull, 0x00008a0101600000ull, 0x3040003412080021ull, 0x3040290220884800ull,
+            0x4a1500401041004aull, 0x8010200282020781ull, 0x0020203142209091ull, 0x0070300600902110ull,
+            0x0040808800b62048ull, 0x0000810400c44420ull, 0x00080400440c0441ull, 0x8340080020840411ull,
+            0x0000000104208200ull, 0x0000800810d00080ull, 0x0400530411080200ull, 0x4040702400932244ull
+    };
+    constexpr static std::array<Bitboard, 64> rookMagics{
+            0x1080004008801020ull, 0x0840092002c03000ull, 0x1900200010400900ull, 0x0880100008000480ull,
+            0x4200100420080200ull, 0x8100020100080400ull, 0x0200040110886200ull, 0x0200008040220411ull,
+            0x0404800084400220ull, 0x0000401000402000ull, 0x0086001081220440ull, 0x0408800800100280ull,
+            0x000a001201040820ull, 0x8848800200840080ull, 0x4001000100040200ull, 0x0442000102105084ull,
+            0x9080010020804100ull, 0x0040404000201009ull, 0x0000808010002009ull, 0x2200090021d00100ull,
+            0x0008008008040080ull, 0x0004004002010040ull, 0x0011040008015042ull, 0x00000a0001768104ull,
+            0x0000800080204009ull, 0x2010004140002001ull, 0x9800200280100080ull, 0x1000100080080080ull,
+            0x0442000a00049020ull, 0x2100040080020080ull, 0x0800120400900148ull, 0x0010040a00128541ull,
+            0x2800804000800030ull, 0x1010002000400041ull, 0x4000200011004100ull, 0x0610008410800800ull,
+            0x0400802402800800ull, 0xc100020080800400ull, 0x0002000802000401ull, 0x0182085882000401ull,
+            0x0220204000808000ull, 0x2860100040024022ull, 0x0001002004110040ull, 0x99101042000a0020ull,
+            0x0004080004008080ull, 0x0010040002008080ull, 0x2012004881020004ull, 0x8300842444820011ull,
+            0x0088403882010200ull, 0x0820400080210100ull, 0x0110910040a00300ull, 0x0801100280080480ull,
+            0x0242009008200600ull, 0x1002000489500200ull, 0x0040800200010080ull, 0x0091800041000080ull,
+            0x0000209300488001ull, 0x04c1002414824001ull, 0x020020000b001041ull, 0x7000100004200901ull,
+            0x8002002004100802ull, 0x30010002084c0007ull, 0x0888221800813004ull, 0x4000002840840112ull
+    };
+
+    // sizes of attack tables of all squares: sum of 2^(bits of mask)
+    constexpr static int bishopTableSize = 5248;
+    constexpr static int rookTableSize = 102400;
+
+    struct Magic {
+        Bitboard mask; // relevant occupancy, edges of rays are left out
+        Bitboard magic;
+        int shift;
+        Bitboard *attacks;
+
+        size_t index(Bitboard occupied) const {
+#if defined(__BMI2__)
+            return _pext_u64(occupied, mask);
+#else
+            return ((occupied & mask) * magic) >> shift;
+#endif
+        }
+
+        Bitboard lookup(Bitboard occupied) const {
+            return attacks[index(occupied)];
+        }
+    };
+
+    struct Tables {
+        std::array<std::array<Bitboard, 64>, 2> pawn;
+        std::array<Bitboard, 64> knight;
+        std::array<Bitboard, 64> king;
+        std::array<Magic, 64> bishop;
+        std::array<Magic, 64> rook;
+        std::array<Bitboard, bishopTableSize + rookTableSize> slidingAttacks;
+        std::array<std::array<Bitboard, 64>, 64> line;
+        std::array<std::array<Bitboard, 64>, 64> between;
+
+        Tables() {
+            constexpr std::array<std::array<int, 2>, 8> knightSteps{
+                    {{-2, -1}, {-2, 1}, {-1, -2}, {-1, 2}, {1, -2}, {1, 2}, {2, -1}, {2, 1}}};
+            constexpr std::array<std::array<int, 2>, 8> kingSteps{
+                    {{-1, -1}, {-1, 0}, {-1, 1}, {0, -1}, {0, 1}, {1, -1}, {1, 0}, {1, 1}}};
+            for (int square = 0; square < 64; square++) {
+                pawn[0][square] = step(square, -1, -1) | step(square, -1, 1); // white pawns go to row 0 (rank 8)
+                pawn[1][square] = step(square, 1, -1) | step(square, 1, 1);
+                knight[square] = 0;
+                for (auto[row, file]: knightSteps) {
+                    knight[square] |= step(square, row, file);
+                }
+                king[square] = 0;
+                for (auto[row, file]: kingSteps) {
+                    king[square] |= step(square, row, file);
+                }
+            }
+            Bitboard *next = slidingAttacks.data();
+            initMagics(bishop, bishopMagics, bishopDirections, next);
+            initMagics(rook, rookMagics, rookDirections, next);
+
+            for (int square1 = 0; square1 < 64; square1++) {
+                for (int square2 = 0; square2 < 64; square2++) {
+                    Bitboard bit1 = Bitboard(1) << square1;
+                    Bitboard bit2 = Bitboard(1) << square2;
+                    line[square1][square2] = 0;
+                    between[square1][square2] = 0;
+                    for (const std::array<Magic, 64> *magics: {&bishop, &rook}) {
+                        const Magic &magic1 = (*magics)[square1];
+                        const Magic &magic2 = (*magics)[square2];
+                        if (magic1.lookup(0) & bit2) {
+                            line[square1][square2] = (magic1.lookup(0) & magic2.lookup(0)) | bit1 | bit2;
+                            between[square1][square2] = magic1.lookup(bit2) & magic2.lookup(bit1);
+                        }
+                    }
+                }
+            }
+        }
+
+        // square moved by given rows and files, empty when it leaves the board
+        static Bitboard step(int square, int rows, int files) {
+            int row = square / 8 + rows;
+            int file = square % 8 + files;
+            return row >= 0 && row < 8 && file >= 0 && file < 8 ? Bitboard(1) << (row * 8 + file) : 0;
+        }
+
+        // attacks computed by walking rays, used only to fill the tables
+        static Bitboard slowAttacks(int square, Bitboard occupied, const Directions &directions) {
+            Bitboard attacks = 0;
+            for (auto[rows, files]: directions) {
+                for (int ray = square; Bitboard next = step(ray, rows, files);) {
+                    attacks |= next;
+                    if (occupied & next) {
+                        break;
+                    }
+                    ray = std::countr_zero(next);
+                }
+            }
+            return attacks;
+        }
+
+        static Bitboard relevantOccupancy(int square, const Directions &directions) {
+            Bitboard mask = 0;
+            for (auto[rows, files]: directions) {
+                for (int ray = square; Bitboard next = step(ray, rows, files);) {
+                    ray = std::countr_zero(next);
+                    if (step(ray, rows, files)) {
+                        mask |= next;
+                    }
+                }
+            }
+            return mask;
+        }
+
+        static void initMagics(std::array<Magic, 64> &magics, const std::array<Bitboard, 64> &magicNumbers,
+                               const Directions &directions, Bitboard *&next) {
+            for (int square = 0; square < 64; square++) {
+                Magic &magic = magics[square];
+                magic.mask = relevantOccupancy(square, directions);
+                magic.magic = magicNumbers[square];
+                magic.shift = 64 - std::popcount(magic.mask);
+                magic.attacks = next;
+                next += Bitboard(1) << std::popcount(magic.mask);
+
+                // every subset of mask (carry rippler)
+                Bitboard occupied = 0;
+                do {
+                    magic.attacks[magic.index(occupied)] = slowAttacks(square, occupied, directions);
+                    occupied = (occupied - magic.mask) & magic.mask;
+                } while (occupied != 0);
+            }
+        }
+    };
+
+    static const Tables tables;
+};
+
+inline const BitboardAttacks::Tables BitboardAttacks::tables;
+
+// Position as per piece bitboards. It does not replace thc::ChessRules, it is kept next to it: moves are thc::Move
+// (same squares, special and capture fields) and are made on both boards, so search can generate moves and test
+// attacks here, while hashing still reads thc mailbox. Material and piece square tables of both sides are summed by
+// every piece put, removed or moved, so evaluation does not scan the board for them.
+class BitboardPosition {
+public:
+    using Bitboard = BitboardAttacks::Bitboard;
+
+    enum Piece {
+        Pawn, Knight, Bishop, Rook, Queen, King
+    };
+
+    BitboardPosition() {
+        squares.fill(' ');
+    }
+
+    explicit BitboardPosition(const thc::ChessRules &board) {
+        fromChessRules(board);
+    }
+
+    // position can be built only from board with exactly one king of each side (king square is looked up everywhere)
+    static bool hasBothKings(const thc::ChessRules &board) {
+        int whiteKings = 0;
+        int blackKings = 0;
+        for (int square = 0; square < 64; square++) {
+            whiteKings += board.squares[square] == 'K';
+            blackKings += board.squares[square] == 'k';
+        }
+        return whiteKings == 1 && blackKings == 1;
+    }
+
+    void fromChessRules(const thc::ChessRules &board) {
+        pieceSets.fill(0);
+        colourSets.fill(0);
+        occupied = 0;
+        pieceSquareScores.fill(0);
+        squares.fill(' ');
+        for (int square = 0; square < 64; square++) {
+            if (board.squares[square] != ' ') {
+                put(square, board.squares[square]);
+            }
+        }
+        white = board.white;
+        enpassantTarget = board.enpassant_target == thc::SQUARE_INVALID ? noSquare : int(board.enpassant_target);
+        castling = (board.wking_allowed() ? whiteKingSide : 0) | (board.wqueen_allowed() ? whiteQueenSide : 0) |
+                   (board.bking_allowed() ? blackKingSide : 0) | (board.bqueen_allowed() ? blackQueenSide : 0);
+        undoCount = 0;
+    }
+
+    bool whiteToPlay() const {
+        return white;
+    }
+
+    Bitboard pieces(bool whitePieces, Piece piece) const {
+        return pieceSets[(whitePieces ? 0 : 6) + piece];
+    }
+
+    Bitboard pieces(bool whitePieces) const {
+        return colourSets[whitePieces ? 0 : 1];
+    }
+
+    int kingSquare(bool whiteKing) const {
+        return std::countr_zero(pieces(whiteKing, King));
+    }
+
+    // material and piece square tables (ChessBoardWeights.h) of pieces of given colour in centipawns, black tables
+    // are rotated by 180 degrees
+    int pieceSquareScore(bool whitePieces) const {
+        return pieceSquareScores[whitePieces ? 0 : 1];
+    }
+
+    // index in pieceSets and in tables of ChessBoardWeights.h, colour * 6 + Piece
+    constexpr static int pieceIndex(char piece) {
+        switch (piece) {
+            case 'P':
+                return Pawn;
+            case 'N':
+                return Knight;
+            case 'B':
+                return Bishop;
+            case 'R':
+                return Rook;
+            case 'Q':
+                return Queen;
+            case 'K':
+                return King;
+            case 'p':
+                return 6 + Pawn;
+            case 'n':
+                return 6 + Knight;
+            case 'b':
+                return 6 + Bishop;
+            case 'r':
+                return 6 + Rook;
+            case 'q':
+                return 6 + Queen;
+        }
+        return 6 + King;
+    }
+
+    // any piece other than pawns and king
+    bool hasPieces(bool whitePieces) const {
+        return (pieces(whitePieces) & ~pieces(whitePieces, Pawn) & ~pieces(whitePieces, King)) != 0;
+    }
+
+    bool attacked(int square, bool byWhite) const {
+        return attacked(square, byWhite, occupied);
+    }
+
+    // pieces of given colour attacking square
+    Bitboard attackers(int square, bool byWhite) const {
+        return (BitboardAttacks::pawn(square, !byWhite) & pieces(byWhite, Pawn)) |
+               (BitboardAttacks::knight(square) & pieces(byWhite, Knight)) |
+               (BitboardAttacks::king(square) & pieces(byWhite, King)) |
+               (BitboardAttacks::bishop(square, occupied) & (pieces(byWhite, Bishop) | pieces(byWhite, Queen))) |
+               (BitboardAttacks::rook(square, occupied) & (pieces(byWhite, Rook) | pieces(byWhite, Queen)));
+    }
+
+    // attacks of pieces of given colour on squares of zone not occupied by their own pieces, a square attacked by two
+    // pieces counts twice (pseudo legal, pinned pieces are counted too)
+    int attackCount(Bitboard zone, bool byWhite) const {
+        Bitboard targets = zone & ~pieces(byWhite);
+        int count = std::popcount(BitboardAttacks::king(kingSquare(byWhite)) & targets);
+        for (Bitboard pawns = pieces(byWhite, Pawn); pawns != 0; pawns &= pawns - 1) {
+            count += std::popcount(BitboardAttacks::pawn(std::countr_zero(pawns), byWhite) & targets);
+        }
+        for (Bitboard knights = pieces(byWhite, Knight); knights != 0; knights &= knights - 1) {
+            count += std::popcount(BitboardAttacks::knight(std::countr_zero(knights)) & targets);
+        }
+        for (Bitboard diagonal = pieces(byWhite, Bishop) | pieces(byWhite, Queen);
+             diagonal != 0; diagonal &= diagonal - 1) {
+            count += std::popcount(BitboardAttacks::bishop(std::countr_zero(diagonal), occupied) & targets);
+        }
+        for (Bitboard straight = pieces(byWhite, Rook) | pieces(byWhite, Queen);
+             straight != 0; straight &= straight - 1) {
+            count += std::popcount(BitboardAttacks::rook(std::countr_zero(straight), occupied) & targets);
+        }
+        return count;
+    }
+
+    // side to move is in check
+    bool inCheck() const {
+        return attacked(kingSquare(white), !white);
+    }
+
+    // after pushMove: pseudo legal move did not leave own king in check
+    bool lastMoveLegal() const {
+        return !attacked(kingSquare(!white), white);
+    }
+
+    // same moves as thc::ChessRules::GenLegalMoveList, without making them
+    void genLegalMoves(thc::MOVELIST *list) const {
+        generate(list, false);
+    }
+
+    // cheaper than genLegalMoves when it is enough to know whether side to move has any move (mate, stalemate):
+    // king moves are tried first and only when king cannot move, all moves are generated
+    bool hasLegalMove() const {
+        int king = kingSquare(white);
+        Bitboard occupancy = occupied & ~(Bitboard(1) << king);
+        for (Bitboard destinations = BitboardAttacks::king(king) & ~pieces(white);
+             destinations != 0; destinations &= destinations - 1) {
+            if (!attacked(std::countr_zero(destinations), !white, occupancy)) {
+                return true;
+            }
+        }
+        thc::MOVELIST list;
+        generate(&list, false);
+        return list.count > 0;
+    }
+
+    // legal captures and promotions, for quiescence search
+    void genLegalTacticalMoves(thc::MOVELIST *list) const {
+        generate(list, true);
+    }
+
+    // move (src, dst and special), eg. from transposition table, is legal here; its capture is filled
+    bool legalMove(thc::Move &move) {
+        if (squares[move.src] == ' ' || isWhite(squares[move.src]) != white) {
+            return false;
+        }
+        thc::MOVELIST list;
+        list.count = 0;
+        genPieceMoves(&list, move.src, ~pieces(white), ~Bitboard(0), false, false);
+        for (int i = 0; i < list.count; i++) {
+            thc::Move &candidate = list.moves[i];
+            if (candidate.dst == move.dst && candidate.special == move.special) {
+                pushMove(candidate);
+                bool legal = lastMoveLegal();
+                popMove(candidate);
+                if (legal) {
+                    move = candidate;
+                }
+                return legal;
+            }
+        }
+        return false;
+    }
+
+    void pushMove(const thc::Move &move) {
+        undoStack[undoCount++] = {castling, uint8_t(enpassantTarget)};
+        castling &= castlingKept(move.src) & castlingKept(move.dst);
+        enpassantTarget = noSquare;
+        switch (move.special) {
+            case thc::SPECIAL_WK_CASTLING:
+                movePiece(thc::e1, thc::g1);
+                movePiece(thc::h1, thc::f1);
+                break;
+            case thc::SPECIAL_WQ_CASTLING:
+                movePiece(thc::e1, thc::c1);
+                movePiece(thc::a1, thc::d1);
+                break;
+            case thc::SPECIAL_BK_CASTLING:
+                movePiece(thc::e8, thc::g8);
+                movePiece(thc::h8, thc::f8);
+                break;
+            case thc::SPECIAL_BQ_CASTLING:
+                movePiece(thc::e8, thc::c8);
+                movePiece(thc::a8, thc::d8);
+                break;
+            case thc::SPECIAL_PROMOTION_QUEEN:
+            case thc::SPECIAL_PROMOTION_ROOK:
+            case thc::SPECIAL_PROMOTION_BISHOP:
+            case thc::SPECIAL_PROMOTION_KNIGHT:
+                remove(move.src);
+                if (squares[move.dst] != ' ') {
+                    remove(move.dst);
+                }
+                put(move.dst, promotedPiece(move.special));
+                break;
+            case thc::SPECIAL_WEN_PASSANT:
+                remove(move.dst + 8);
+                movePiece(move.src, move.dst);
+                break;
+            case thc::SPECIAL_BEN_PASSANT:
+                remove(move.dst - 8);
+                movePiece(move.src, move.dst);
+                break;
+            case thc::SPECIAL_WPAWN_2SQUARES:
+            case thc::SPECIAL_BPAWN_2SQUARES:
+                movePiece(move.src, move.dst);
+                enpassantTarget = (move.src + move.dst) / 2;
+                break;
+            default:
+                if (squares[move.dst] != ' ') {
+                    remove(move.dst);
+                }
+                movePiece(move.src, move.dst);
+                break;
+        }
+        white = !white;
+    }
+
+    // move has to be the one given to pushMove, with its capture field
+    void popMove(const thc::Move &move) {
+        white = !white;
+        switch (move.special) {
+            case thc::SPECIAL_WK_CASTLING:
+                movePiece(thc::g1, thc::e1);
+                movePiece(thc::f1, thc::h1);
+                break;
+            case thc::SPECIAL_WQ_CASTLING:
+                movePiece(thc::c1, thc::e1);
+                movePiece(thc::d1, thc::a1);
+                break;
+            case thc::SPECIAL_BK_CASTLING:
+                movePiece(thc::g8, thc::e8);
+                movePiece(thc::f8, thc::h8);
+                break;
+            case thc::SPECIAL_BQ_CASTLING:
+                movePiece(thc::c8, thc::e8);
+                movePiece(thc::d8, thc::a8);
+                break;
+            case thc::SPECIAL_PROMOTION_QUEEN:
+            case thc::SPECIAL_PROMOTION_ROOK:
+            case thc::SPECIAL_PROMOTION_BISHOP:
+            case thc::SPECIAL_PROMOTION_KNIGHT:
+                remove(move.dst);
+                put(move.src, white ? 'P' : 'p');
+                if (move.capture != ' ') {
+                    put(move.dst, char(move.capture));
+                }
+                break;
+            case thc::SPECIAL_WEN_PASSANT:
+                movePiece(move.dst, move.src);
+                put(move.dst + 8, 'p');
+                break;
+            case thc::SPECIAL_BEN_PASSANT:
+                movePiece(move.dst, move.src);
+                put(move.dst - 8, 'P');
+                break;
+            default:
+                movePiece(move.dst, move.src);
+                if (move.capture != ' ') {
+                    put(move.dst, char(move.capture));
+                }
+                break;
+        }
+        undoCount--;
+        castling = undoStack[undoCount].castling;
+        enpassantTarget = undoStack[undoCount].enpassantTarget;
+    }
+
+    void pushNullMove() {
+        undoStack[undoCount++] = {castling, uint8_t(enpassantTarget)};
+        enpassantTarget = noSquare;
+        white = !white;
+    }
+
+    void popNullMove() {
+        white = !white;
+        undoCount--;
+        castling = undoStack[undoCount].castling;
+        enpassantTarget = undoStack[undoCount].enpassantTarget;
+    }
+
+private:
+    constexpr static int noSquare = 64;
+    constexpr static int maxPly = 256; // moves which can be pushed at once
+
+    constexpr static uint8_t whiteKingSide = 1;
+    constexpr static uint8_t whiteQueenSide = 2;
+    constexpr static uint8_t blackKingSide = 4;
+    constexpr static uint8_t blackQueenSide = 8;
+
+    struct Undo {
+        uint8_t castling;
+        uint8_t enpassantTarget;
+    };
+
+    static bool isWhite(char piece) {
+        return piece >= 'A' && piece <= 'Z';
+    }
+
+    char promotedPiece(int special) const {
+        switch (special) {
+            case thc::SPECIAL_PROMOTION_QUEEN:
+                return white ? 'Q' : 'q';
+            case thc::SPECIAL_PROMOTION_ROOK:
+                return white ? 'R' : 'r';
+            case thc::SPECIAL_PROMOTION_BISHOP:
+                return white ? 'B' : 'b';
+        }
+        return white ? 'N' : 'n';
+    }
+
+    // castling rights which stay when a move starts or ends on square
+    static uint8_t castlingKept(int square) {
+        switch (square) {
+            case thc::e1:
+                return uint8_t(~(whiteKingSide | whiteQueenSide));
+            case thc::h1:
+                return uint8_t(~whiteKingSide);
+            case thc::a1:
+                return uint8_t(~whiteQueenSide);
+            case thc::e8:
+                return uint8_t(~(blackKingSide | blackQueenSide));
+            case thc::h8:
+                return uint8_t(~blackKingSide);
+            case thc::a8:
+                return uint8_t(~blackQueenSide);
+        }
+        return uint8_t(~0);
+    }
+
+    void put(int square, char piece) {
+        Bitboard bit = Bitboard(1) << square;
+        int index = pieceIndex(piece);
+        int colour = isWhite(piece) ? 0 : 1;
+        pieceSets[index] |= bit;
+        colourSets[colour] |= bit;
+        occupied |= bit;
+        pieceSquareScores[colour] += pieceSquareValues[index][square];
+        squares[square] = piece;
+    }
+
+    void remove(int square) {
+        Bitboard bit = Bitboard(1) << square;
+        char piece = squares[square];
+        int index = pieceIndex(piece);
+        int colour = isWhite(piece) ? 0 : 1;
+        pieceSets[index] &= ~bit;
+        colourSets[colour] &= ~bit;
+        occupied &= ~bit;
+        pieceSquareScores[colour] -= pieceSquareValues[index][square];
+        squares[square] = ' ';
+    }
+
+    void movePiece(int from, int to) {
+        Bitboard bits = (Bitboard(1) << from) | (Bitboard(1) << to);
+        char piece = squares[from];
+        int index = pieceIndex(piece);
+        int colour = isWhite(piece) ? 0 : 1;
+        pieceSets[index] ^= bits;
+        colourSets[colour] ^= bits;
+        occupied ^= bits;
+        pieceSquareScores[colour] += pieceSquareValues[index][to] - pieceSquareValues[index][from];
+        squares[to] = piece;
+        squares[from] = ' ';
+    }
+
+    void addMove(thc::MOVELIST *list, int src, int dst, thc::SPECIAL special) const {
+        thc::Move &move = list->moves[list->count++];
+        move.src = thc::Square(src);
+        move.dst = thc::Square(dst);
+        move.special = special;
+        move.capture = squares[dst];
+    }
+
+    void addMoves(thc::MOVELIST *list, int src, Bitboard destinations, thc::SPECIAL special) const {
+        for (; destinations != 0; destinations &= destinations - 1) {
+            addMove(list, src, std::countr_zero(destinations), special);
+        }
+    }
+
+    // in the order of thc, queen first
+    void addPromotions(thc::MOVELIST *list, int src, int dst) const {
+        addMove(list, src, dst, thc::SPECIAL_PROMOTION_QUEEN);
+        addMove(list, src, dst, thc::SPECIAL_PROMOTION_KNIGHT);
+        addMove(list, src, dst, thc::SPECIAL_PROMOTION_BISHOP);
+        addMove(list, src, dst, thc::SPECIAL_PROMOTION_ROOK);
+    }
+
+    bool attacked(int square, bool byWhite, Bitboard occupancy) const {
+        return (BitboardAttacks::pawn(square, !byWhite) & pieces(byWhite, Pawn)) ||
+               (BitboardAttacks::knight(square) & pieces(byWhite, Knight)) ||
+               (BitboardAttacks::king(square) & pieces(byWhite, King)) ||
+               (BitboardAttacks::bishop(square, occupancy) & (pieces(byWhite, Bishop) | pieces(byWhite, Queen))) ||
+               (BitboardAttacks::rook(square, occupancy) & (pieces(byWhite, Rook) | pieces(byWhite, Queen)));
+    }
+
+    // pieces of side to move, which are the only blocker between own king and enemy slider
+    Bitboard pinnedPieces(int king) const {
+        Bitboard pinned = 0;
+        Bitboard snipers =
+                (BitboardAttacks::rook(king, 0) & (pieces(!white, Rook) | pieces(!white, Queen))) |
+                (BitboardAttacks::bishop(king, 0) & (pieces(!white, Bishop) | pieces(!white, Queen)));
+        for (; snipers != 0; snipers &= snipers - 1) {
+            Bitboard blockers = BitboardAttacks::between(king, std::countr_zero(snipers)) & occupied;
+            if (blockers != 0 && (blockers & (blockers - 1)) == 0) {
+                pinned |= blockers & pieces(white);
+            }
+        }
+        return pinned;
+    }
+
+    // legal moves: checkers and pinned pieces are found once and every piece gets only destinations which keep own
+    // king safe, so moves do not have to be made to test them. In check a move has to capture the checker or block
+    // it (only king moves in double check), pinned piece stays on the line of its king and pinner, king does not go
+    // to attacked square. En passant, which takes two pieces from one rank, is tested by occupancy after it.
+    void generate(thc::MOVELIST *list, bool tacticalOnly) const {
+        list->count = 0;
+        int king = kingSquare(white);
+        Bitboard allowed = ~Bitboard(0);
+        Bitboard checkers = attackers(king, !white);
+        if ((checkers & (checkers - 1)) != 0) {
+            allowed = 0;
+        } else if (checkers != 0) {
+            allowed = checkers | BitboardAttacks::between(king, std::countr_zero(checkers));
+        }
+        Bitboard pinned = pinnedPieces(king);
+        Bitboard targets = tacticalOnly ? pieces(!white) : ~pieces(white);
+        for (Bitboard own = pieces(white); own != 0; own &= own - 1) {
+            int square = std::countr_zero(own);
+            Bitboard pieceAllowed = allowed;
+            if (square == king) {
+                pieceAllowed = ~Bitboard(0);
+            } else if (pinned >> square & 1) {
+                pieceAllowed &= BitboardAttacks::line(king, square);
+            }
+            genPieceMoves(list, square, targets, pieceAllowed, tacticalOnly, true);
+        }
+    }
+
+    // moves of piece of side to move to targets, which end on allowed squares. Pawn pushes and castling are added
+    // unless tacticalOnly (pushes which promote are added always). Without legalOnly king moves into check and
+    // en passant exposing own king are added too (allowed does not restrict pinned pieces then)
+    void genPieceMoves(thc::MOVELIST *list, int square, Bitboard targets, Bitboard allowed, bool tacticalOnly,
+                       bool legalOnly) const {
+        switch (squares[square]) {
+            case 'P':
+            case 'p':
+                genPawnMoves(list, square, allowed, tacticalOnly, legalOnly);
+                break;
+            case 'N':
+            case 'n':
+                addMoves(list, square, BitboardAttacks::knight(square) & targets & allowed, thc::NOT_SPECIAL);
+                break;
+            case 'B':
+            case 'b':
+                addMoves(list, square, BitboardAttacks::bishop(square, occupied) & targets & allowed,
+                         thc::NOT_SPECIAL);
+                break;
+            case 'R':
+            case 'r':
+                addMoves(list, square, BitboardAttacks::rook(square, occupied) & targets & allowed,
+                         thc::NOT_SPECIAL);
+                break;
+            case 'Q':
+            case 'q':
+                addMoves(list, square, BitboardAttacks::queen(square, occupied) & targets & allowed,
+                         thc::NOT_SPECIAL);
+                break;
+            case 'K':
+            case 'k': {
+                Bitboard destinations = BitboardAttacks::king(square) & targets;
+                // king is taken away, so it does not hide squares behind it from sliders
+                Bitboard occupancy = occupied & ~(Bitboard(1) << square);
+                for (; destinations != 0; destinations &= destinations - 1) {
+                    int dst = std::countr_zero(destinations);
+                    if (!legalOnly || !attacked(dst, !white, occupancy)) {
+                        addMove(list, square, dst, thc::SPECIAL_KING_MOVE);
+                    }
+                }
+                if (!tacticalOnly) {
+                    genCastling(list);
+                }
+                break;
+            }
+        }
+    }
+
+    void genPawnMoves(thc::MOVELIST *list, int square, Bitboard allowed, bool tacticalOnly, bool legalOnly) const {
+        int row = square / 8;
+        bool promotion = row == (white ? 1 : 6);
+        for (Bitboard captures = BitboardAttacks::pawn(square, white) & pieces(!white) & allowed;
+             captures != 0; captures &= captures - 1) {
+            int dst = std::countr_zero(captures);
+            if (promotion) {
+                addPromotions(list, square, dst);
+            } else {
+                addMove(list, square, dst, thc::NOT_SPECIAL);
+            }
+        }
+        if (enpassantTarget != noSquare && (BitboardAttacks::pawn(square, white) >> enpassantTarget & 1) &&
+            (!legalOnly || enPassantLegal(square))) {
+            thc::Move &move = list->moves[list->count++];
+            move.src = thc::Square(square);
+            move.dst = thc::Square(enpassantTarget);
+            move.special = white ? thc::SPECIAL_WEN_PASSANT : thc::SPECIAL_BEN_PASSANT;
+            move.capture = white ? 'p' : 'P';
+        }
+
+        int forward = white ? -8 : 8;
+        int push = square + forward;
+        if (occupied >> push & 1) {
+            return;
+        }
+        if (promotion) {
+            if (allowed >> push & 1) {
+                addPromotions(list, square, push);
+            }
+        } else if (!tacticalOnly) {
+            if (allowed >> push & 1) {
+                addMove(list, square, push, thc::NOT_SPECIAL);
+            }
+            if (row == (white ? 6 : 1) && !(occupied >> (push + forward) & 1) && (allowed >> (push + forward) & 1)) {
+                addMove(list, square, push + forward,
+                        white ? thc::SPECIAL_WPAWN_2SQUARES : thc::SPECIAL_BPAWN_2SQUARES);
+            }
+        }
+    }
+
+    // own king is not attacked after en passant by pawn from square
+    bool enPassantLegal(int square) const {
+        int king = kingSquare(white);
+        Bitboard captured = Bitboard(1) << (enpassantTarget + (white ? 8 : -8));
+        Bitboard occupancy = (occupied ^ (Bitboard(1) << square) ^ captured) | (Bitboard(1) << enpassantTarget);
+        return !(BitboardAttacks::bishop(king, occupancy) & (pieces(!white, Bishop) | pieces(!white, Queen))) &&
+               !(BitboardAttacks::rook(king, occupancy) & (pieces(!white, Rook) | pieces(!white, Queen))) &&
+               !(BitboardAttacks::knight(king) & pieces(!white, Knight)) &&
+               !(BitboardAttacks::pawn(king, white) & pieces(!white, Pawn) & ~captured);
+    }
+
+    // king and rook are on their squares whenever the right is kept, squares between them have to be empty and
+    // king cannot pass attacked square
+    void genCastling(thc::MOVELIST *list) const {
+        auto empty = [this](std::initializer_list<int> castlingSquares) {
+            for (int square: castlingSquares) {
+                if (squares[square] != ' ') {
+                    return false;
+                }
+            }
+            return true;
+        };
+        auto safe = [this](std::initializer_list<int> castlingSquares) {
+            for (int square: castlingSquares) {
+                if (attacked(square, !white)) {
+                    return false;
+                }
+            }
+            return true;
+        };
+        if (white) {
+            if ((castling & whiteKingSide) && empty({thc::f1, thc::g1}) && safe({thc::e1, thc::f1, thc::g1})) {
+                addMove(list, thc::e1, thc::g1, thc::SPECIAL_WK_CASTLING);
+            }
+            if ((castling & whiteQueenSide) && empty({thc::b1, thc::c1, thc::d1}) &&
+                safe({thc::e1, thc::d1, thc::c1})) {
+                addMove(list, thc::e1, thc::c1, thc::SPECIAL_WQ_CASTLING);
+            }
+        } else {
+            if ((castling & blackKingSide) && empty({thc::f8, thc::g8}) && safe({thc::e8, thc::f8, thc::g8})) {
+                addMove(list, thc::e8, thc::g8, thc::SPECIAL_BK_CASTLING);
+            }
+            if ((castling & blackQueenSide) && empty({thc::b8, thc::c8, thc::d8}) &&
+                safe({thc::e8, thc::d8, thc::c8})) {
+                addMove(list, thc::e8, thc::c8, thc::SPECIAL_BQ_CASTLING);
+            }
+        }
+    }
+
+    std::array<Bitboard, 12> pieceSets{}; // [colour * 6 + Piece], white is colour 0
+    std::array<Bitboard, 2> colourSets{};
+    Bitboard occupied = 0;
+    std::array<int, 2> pieceSquareScores{};
+    std::array<char, 64> squares; // thc piece characters, ' ' is empty square
+    bool white = true;
+    int enpassantTarget = noSquare;
+    uint8_t castling = 0;
+
+    std::array<Undo, maxPly> undoStack;
+    int undoCount = 0;
+};
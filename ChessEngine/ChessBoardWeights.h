@@ -1,9 +1,15 @@
 #pragma once
 
-#include <vector>
-#include <map>
+#include <array>
 
-const std::vector<int> pawnsOnBoardPositions = {
+// piece square tables are in 1/boardPositionWeightDivisor of pawn, square 0 is a8 and black uses square 63 - square:
+// the table rotated by 180 degrees, which equals the vertical mirror (square ^ 56) only for tables symmetric from left
+// to right (queen table is not)
+constexpr int boardPositionWeightDivisor = 300;
+
+using PieceSquareTable = std::array<int, 64>;
+
+constexpr PieceSquareTable pawnsOnBoardPositions = {
         0, 0, 0, 0, 0, 0, 0, 0,
         50, 50, 50, 50, 50, 50, 50, 50,
         10, 10, 20, 30, 30, 20, 10, 10,
@@ -14,7 +20,7 @@ const std::vector<int> pawnsOnBoardPositions = {
         0, 0, 0, 0, 0, 0, 0, 0
 };
 
-const std::vector<int> knightsOnBoardPositions = {
+constexpr PieceSquareTable knightsOnBoardPositions = {
         -50, -40, -30, -30, -30, -30, -40, -50,
         -40, -20, 0, 0, 0, 0, -20, -40,
         -30, 0, 10, 15, 15, 10, 0, -30,
@@ -25,7 +31,7 @@ const std::vector<int> knightsOnBoardPositions = {
         -50, -40, -30, -30, -30, -30, -40, -50
 };
 
-const std::vector<int> bishopsOnBoardPositions = {
+constexpr PieceSquareTable bishopsOnBoardPositions = {
         -20, -10, -10, -10, -10, -10, -10, -20,
         -10, 0, 0, 0, 0, 0, 0, -10,
         -10, 0, 5, 10, 10, 5, 0, -10,
@@ -36,7 +42,7 @@ const std::vector<int> bishopsOnBoardPositions = {
         -20, -10, -10, -10, -10, -10, -10, -20
 };
 
-const std::vector<int> rookOnBoardPositions = {
+constexpr PieceSquareTable rookOnBoardPositions = {
         0,  0,  0,  0,  0,  0,  0,  0,
         5,  10, 10, 10, 10, 10, 10, 5,
         -5, 0,  0,  0,  0,  0,  0,  -5,
@@ -47,7 +53,7 @@ const std::vector<int> rookOnBoardPositions = {
         0,  0,  0,  5,  5,  0,  0,  0
 };
 
-const std::vector<int> queenOnBoardPositions = {
+constexpr PieceSquareTable queenOnBoardPositions = {
         -20, -10, -10, -5, -5, -10, -10, -20,
         -10, 0,   0,   0,  0,  0,   0,   -10,
         -10, 0,   5,   5,  5,  5,   0,   -10,
@@ -58,7 +64,7 @@ const std::vector<int> queenOnBoardPositions = {
         -20, -10, -10, -5, -5, -10, -10, -20
 };
 
-const std::vector<int> kingOnBoardPositions = {
+constexpr PieceSquareTable kingOnBoardPositions = {
         -30, -40, -40, -50, -50, -40, -40, -30,
         -30, -40, -40, -50, -50, -40, -40, -30,
         -30, -40, -40, -50, -50, -40, -40, -30,
@@ -69,12 +75,30 @@ const std::vector<int> kingOnBoardPositions = {
         20,  30,  10,  0,   0,   10,  30,  20
 };
 
-std::map<char, std::vector<int>> mapOfPiecePositions
-        {
-                {'p', pawnsOnBoardPositions},
-                {'k', knightsOnBoardPositions},
-                {'b', bishopsOnBoardPositions},
-                {'r', rookOnBoardPositions},
-                {'q', queenOnBoardPositions},
-                {'k', kingOnBoardPositions}
-        };
\ No newline at end of file
+// pieces in order pawn, knight, bishop, rook, queen, king; tables below are indexed [colour * 6 + piece], white is 0
+constexpr std::array<PieceSquareTable, 6> pieceSquareTables = {
+        pawnsOnBoardPositions, knightsOnBoardPositions, bishopsOnBoardPositions,
+        rookOnBoardPositions, queenOnBoardPositions, kingOnBoardPositions
+};
+
+constexpr std::array<int, 6> pieceMaterialValues = {1, 3, 3, 5, 9, 0};
+
+// piece square table value rounded to nearest centipawn (halves away from zero, so rotated black tables stay symmetric)
+constexpr int toCentipawns(int weight) {
+    int half = boardPositionWeightDivisor / 2;
+    return (weight * 100 + (weight >= 0 ? half : -half)) / boardPositionWeightDivisor;
+}
+
+// material and piece square table of every piece on every square in centipawns, converted once here, so sums kept
+// by BitboardPosition need no division
+constexpr std::array<PieceSquareTable, 12> pieceSquareValues = [] {
+    std::array<PieceSquareTable, 12> values{};
+    for (int piece = 0; piece < 6; piece++) {
+        int material = pieceMaterialValues[piece] * 100;
+        for (int square = 0; square < 64; square++) {
+            values[piece][square] = material + toCentipawns(pieceSquareTables[piece][square]);
+            values[6 + piece][square] = material + toCentipawns(pieceSquareTables[piece][63 - square]);
+        }
+    }
+    return values;
+}();
@@ -2,53 +2,71 @@
 
 #include <functional>
 #include <chrono>
-#include <unordered_map>
 #include <unordered_set>
 #include <iostream>
 #include <array>
 #include <numeric>
+#include <cstdlib>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <vector>
 #include "chess_rules/thc.h"
+#include "BitboardPosition.h"
+#include "TranspositionTable.h"
+#include "TimeManager.h"
+#include "MovePicker.h"
 
 #define MOVE_ORDERING
 
-//#define GENERATE_MOVES_WITH_ADDITIONAL_DATA
-
-#define TIME_OUT 3'000
-
 //#define DEBUG_STATS
+//#define DEBUG_HASH
 #define HASH_TABLE
 
+#define QUIESCENCE_SEARCH
+
 #define ANTY_3_FOLD_REPETITION
 
+// evaluation of position in centipawns, positive is good for white
+using EvaluationFunction = std::function<int(const BitboardPosition &position)>;
+
+// Evaluator is called at every leaf with the same arguments as EvaluationFunction. A function object type (a class
+// with operator()) is called directly and can be inlined into the search, default std::function takes any callable
+// at the cost of indirect call.
+template<typename Evaluator = EvaluationFunction>
 class MinMax {
 public:
-    constexpr static size_t knownPositionsSizeLimit = 50'000'000;
-
-    struct PairHash {
-        template<class T1, class T2>
-        std::size_t operator()(const std::pair<T1, T2> &pair) const {
-            return std::hash<T1>()(pair.first) ^ std::hash<T2>()(pair.second);
-        }
+    // LazySmp - all threads search the same root, sharing transposition table
+    // Ybwc - young brothers wait: first move of a node is searched alone, then its siblings are split between threads
+    enum class ParallelMode {
+        LazySmp, Ybwc
     };
 
+    // 64 bit Zobrist key, includes side to move, castling rights and en passant target
+    using HashType = uint64_t;
 
-    using HashType = std::pair<uint64_t, uint32_t>;
-    enum class HashFlag {
-        Exact, Alpha, Beta
-    };
-    struct HashEntry {
-        int remainingDepth;
-        float evaluation;
-        HashFlag hashFlag;
-    };
+    // centipawns, positive is good for white; side to move mated n plies from root scores -(mateScore - n) for
+    // white and mateScore - n for black, so shorter mate is better
+    using Score = int;
+    constexpr static Score mateScore = 30000;
+    constexpr static Score infinity = mateScore + 1;
+    constexpr static int maxMatePlies = 1000;
 
-    using KnownPositionsType = std::unordered_map<HashType, HashEntry, PairHash>;
-    // int is remaining depth after getting to this position (it is possible to get to known position, but with better depth)
+    static bool isMate(Score score) {
+        return std::abs(score) > mateScore - maxMatePlies;
+    }
+
+    // moves (of the winning side) to mate for mate score
+    static int mateInMoves(Score score) {
+        return (mateScore - std::abs(score) + 1) / 2;
+    }
 
 
-    MinMax(int maxDepth_, std::function<float(thc::ChessRules &board)> evaluationFunction_) : evaluationFunction{
-            evaluationFunction_}, maxDepth{maxDepth_} {
-        knownPositions.reserve(knownPositionsSizeLimit);
+    MinMax(int maxDepth_, Evaluator evaluationFunction_, size_t hashSizeMb = TranspositionTable::defaultSizeMb)
+            : evaluationFunction{evaluationFunction_},
+              maxDepth{maxDepth_},
+              knownPositions{hashSizeMb} {
 #ifdef ANTY_3_FOLD_REPETITION
         gameHistory.reserve(100);
 #endif
@@ -66,6 +84,59 @@ public:
 #endif
     }
 
+    // transposition table is cleared, its size is rounded down to power of two buckets
+    void setHashSize(size_t hashSizeMb) {
+        knownPositions.resize(hashSizeMb);
+    }
+
+    size_t getHashSizeMb() const {
+        return knownPositions.sizeMb();
+    }
+
+    // number of threads searching the same root (lazy SMP), they share only transposition table
+    void setThreads(int threads) {
+        threadsCount = std::max(threads, 1);
+    }
+
+    void setParallelMode(ParallelMode mode) {
+        parallelMode = mode;
+    }
+
+    // null move pruning: side to move passes and reduced search still fails high, so the node is cut off
+    void setNullMovePruning(bool enabled) {
+        nullMovePruning = enabled;
+    }
+
+    // late move reductions: quiet moves ordered late are searched shallower first
+    void setLateMoveReductions(bool enabled) {
+        lateMoveReductions = enabled;
+    }
+
+    // plies added by every iteration of iterative deepening, first iteration searches this depth (at most maxDepth),
+    // step below 1 is rejected and the current one is kept
+    bool setDepthStep(int plies) {
+        if (plies < 1) {
+            return false;
+        }
+        depthStep = plies;
+        return true;
+    }
+
+    // time limit of single run() in ms, 0 means no limit
+    void setTimeLimit(int timeLimitMs) {
+        timeManager.setMoveTime(timeLimitMs);
+    }
+
+    // time for next run() is taken from game clock, has to be set before every move
+    void setClock(int remainingMs, int incrementMs, int movesToGo = 0) {
+        timeManager.setClock(remainingMs, incrementMs, movesToGo);
+    }
+
+    // stops search in progress (can be called from other thread), run() returns best move found so far
+    void stop() {
+        stopSearch = true;
+    }
+
 
 #ifdef DEBUG_STATS
 
@@ -73,47 +144,95 @@ public:
         std::cout << "\nEvaluation function invoke counter: " << evaluationFunctionInvokeCounter << "\n";
         std::cout << "\nHash skips counter: " << hashSkipsCounter << "\n";
         std::cout << "\nHash alpha beta cut offs: " << alphaBetaCutOffs << "\n";
+        std::cout << "\nFirst move cut off rate: "
+                  << (alphaBetaCutOffs > 0 ? double(firstMoveCutOffs) / double(alphaBetaCutOffs) : 0.) << "\n";
+        std::cout << "\nPVS re-searches: " << pvsResearches << "\n";
+        std::cout << "\nAspiration re-searches: " << aspirationResearches << "\n";
+        std::cout << "\nNull move cut offs: " << nullMoveCutOffs << "\n";
+        std::cout << "\nHash move cut offs (before move generation): " << hashMoveCutOffs << "\n";
+        std::cout << "\nLMR re-searches: " << lmrResearches << "\n";
     }
 
     void resetDebugStats() {
         hashSkipsCounter = 0;
         alphaBetaCutOffs = 0;
+        firstMoveCutOffs = 0;
         evaluationFunctionInvokeCounter = 0;
+        pvsResearches = 0;
+        aspirationResearches = 0;
+        nullMoveCutOffs = 0;
+        hashMoveCutOffs = 0;
+        lmrResearches = 0;
     }
 
 #endif
 
 
-    std::pair<thc::Move, float> run(thc::ChessRules board) {
-        constexpr int depthIncrement = 2;
-        float eval = 0.f;
-
+    std::pair<thc::Move, Score> run(thc::ChessRules board) {
         std::cout << "Depth: ";
-        minMaxStart = std::chrono::high_resolution_clock::now();
-#ifdef TIME_OUT
-        try {
-#endif
-
+        timeManager.start();
 
         HashType hash = calculateHash(board);
+        knownPositions.newSearch();
+        stopSearch = false;
+        completedDepth = 0;
+        bestEval = 0;
+        // search stopped before any root move is finished still returns legal move, not one from previous run()
+        bestMove.Invalid();
+        thc::MOVELIST rootMoves;
+        BitboardPosition(board).genLegalMoves(&rootMoves);
+        if (rootMoves.count > 0) {
+            bestMove = rootMoves.moves[0];
+        }
 
-        for (int depth = 2; depth <= maxDepth; depth += depthIncrement) {
-            currentMaxDepth = depth;
-            std::cout << depth << " | ";
-            eval = minMax(board, hash, 0);
-            bestMove = currBestMove;
-            if (eval == 1000.f || eval == -1000.f) {
-                break;
+        std::vector<SearchState> states(threadsCount, SearchState(maxDepth));
+        std::vector<std::thread> helpers;
+        for (int i = 1; i < threadsCount; i++) {
+            if (parallelMode == ParallelMode::Ybwc) {
+                helpers.emplace_back([this, &state = states[i]]() {
+                    splitWorker(state);
+                });
+                continue;
             }
+            // every second helper starts one ply deeper, so threads do not search in lockstep
+            helpers.emplace_back([this, board, hash, &state = states[i], i]() mutable {
+                iterativeDeepening(state, board, hash, depthStep + i % 2);
+            });
+        }
+
+        iterativeDeepening(states[0], board, hash, depthStep, true);
+        bool timeOut = stopSearch;
+        {
+            std::lock_guard<std::mutex> lock(splitMutex);
+            stopSearch = true;
+        }
+        splitCondition.notify_all();
+        for (auto &helper: helpers) {
+            helper.join();
+        }
+        if (timeOut) {
+            std::cout << "TIME IS OUT: finished depth: " << completedDepth << std::endl;
         }
-#ifdef TIME_OUT
-        } catch (TimeOut &) {
-            std::cout << "TIME IS OUT: finished depth: " << currentMaxDepth - depthIncrement << std::endl;
+
+        lastSearchNodes = 0;
+        for (const auto &state: states) {
+            lastSearchNodes += state.nodes;
+        }
+        std::cout << "Time: " << timeManager.elapsedMs() << "ms | Nodes: " << lastSearchNodes << "\n";
+
+#ifdef DEBUG_STATS
+        for (const auto &state: states) {
+            evaluationFunctionInvokeCounter += state.evaluationFunctionInvokeCounter;
+            hashSkipsCounter += state.hashSkipsCounter;
+            alphaBetaCutOffs += state.alphaBetaCutOffs;
+            firstMoveCutOffs += state.firstMoveCutOffs;
+            pvsResearches += state.pvsResearches;
+            aspirationResearches += state.aspirationResearches;
+            nullMoveCutOffs += state.nullMoveCutOffs;
+            hashMoveCutOffs += state.hashMoveCutOffs;
+            lmrResearches += state.lmrResearches;
         }
 #endif
-        auto minMaxEnd = std::chrono::high_resolution_clock::now();
-        auto ms_int = std::chrono::duration_cast<std::chrono::milliseconds>(minMaxEnd - minMaxStart);
-        std::cout << "Time: " << ms_int.count() << "ms\n";
 
 #ifdef ANTY_3_FOLD_REPETITION
         board.PushMove(bestMove);
@@ -122,394 +241,866 @@ public:
         board.PopMove(bestMove);
 #endif
 
-        return {bestMove, eval};
+        return {bestMove, bestEval};
+    }
+
+    uint64_t getLastSearchNodes() const {
+        return lastSearchNodes;
+    }
+
+    // depth of the deepest iteration finished by last run()
+    int getLastCompletedDepth() const {
+        return completedDepth;
     }
 
 
 private:
-#ifdef TIME_OUT
-    struct TimeOut {
-    };
-#endif
+    // null window width for principal variation search
+    constexpr static Score nullWindow = 1;
 
-    float minMax(thc::ChessRules &board, HashType boardHash, int depth,
-                 float alpha = std::numeric_limits<float>::lowest(),
-                 float beta = std::numeric_limits<float>::max()) {
-#ifdef HASH_TABLE
-        auto insertBoardToHashTable = [this](HashType hash, float val, HashFlag hashFlag, int depth) {
-            if (knownPositions.contains(hash)) {
-                if (knownPositions[hash].remainingDepth < currentMaxDepth - depth) {
-                    knownPositions.at(hash) = {currentMaxDepth - depth, val, hashFlag};
-                }
-            } else if (knownPositions.size() < knownPositionsSizeLimit) {
-                knownPositions[hash] = {currentMaxDepth - depth, val, hashFlag};
-            }
-        };
-        HashFlag hashFlag = HashFlag::Exact;
-        if (board.WhiteToPlay()) {
-            hashFlag = HashFlag::Beta;
-        } else {
-            hashFlag = HashFlag::Alpha;
-        }
+    // first aspiration window is expected evaluation +- aspirationWindow, above maxAspirationWindow it is infinite
+    constexpr static Score aspirationWindow = 25;
+    constexpr static Score maxAspirationWindow = 2000;
+
+    // clock is read once per this many nodes
+    constexpr static uint64_t nodesBetweenTimeChecks = 1024;
+
+    // null move is searched with remaining depth reduced by nullMoveReduction, only when at least
+    // minNullMoveDepth plies remain
+    constexpr static int nullMoveReduction = 2;
+    constexpr static int minNullMoveDepth = 3;
+
+    // quiet moves after the first lmrFullDepthMoves are searched lmrReduction plies shallower, only when at least
+    // minLmrDepth plies remain
+    constexpr static int lmrFullDepthMoves = 3;
+    constexpr static int lmrReduction = 1;
+    constexpr static int minLmrDepth = 3;
+
+    // history of quiet move grows with every its cut off up to this value
+    constexpr static int maxHistory = 1 << 24;
+
+#ifdef MOVE_ORDERING
+    constexpr static bool moveOrdering = true;
+#else
+    constexpr static bool moveOrdering = false;
 #endif
 
-#ifdef ANTY_3_FOLD_REPETITION
-        if (gameHistory.contains(boardHash)) {
-            return 0.f;
+    // remaining depth needed to split node between threads (ParallelMode::Ybwc)
+    constexpr static int minSplitDepth = 3;
+
+    // node, which moves (except the first one) are searched by several threads,
+    // cut off in one of them cancels split point and every split point below it
+    struct SplitPoint {
+        SplitPoint(SplitPoint *parent, const thc::ChessRules &board, const BitboardPosition &position,
+                   HashType boardHash, int depth, int currentMaxDepth, const thc::Move *moves, int movesCount,
+                   int ply, thc::Move previousMove, Score alpha, Score beta)
+                : parent(parent), board(board), position(position), boardHash(boardHash), depth(depth),
+                  currentMaxDepth(currentMaxDepth), moves(moves), movesCount(movesCount), ply(ply),
+                  previousMove(previousMove), alpha(alpha), beta(beta) {
+            bestMove.Invalid();
         }
-#endif
 
-        thc::TERMINAL evalPos;
-        board.Evaluate(evalPos);
-        if (evalPos != thc::TERMINAL::NOT_TERMINAL || depth == currentMaxDepth) {
-            if (evalPos == thc::TERMINAL::TERMINAL_BCHECKMATE) {    //black is mated
-                return 1000.f;
-            } else if (evalPos == thc::TERMINAL::TERMINAL_WCHECKMATE) { //white is mated
-                return -1000.f;
-            } else if (evalPos == thc::TERMINAL::TERMINAL_BSTALEMATE ||
-                       evalPos == thc::TERMINAL::TERMINAL_WSTALEMATE) {    //stalemate
-                return 0.f;
-            } else {
-                float eval = evaluationFunction(board);
-#ifdef DEBUG_STATS
-                evaluationFunctionInvokeCounter++;
-#endif
-                return eval;
+        SplitPoint *parent;
+        thc::ChessRules board;
+        BitboardPosition position;
+        HashType boardHash;
+        int depth;
+        int currentMaxDepth;
+        const thc::Move *moves;
+        int movesCount;
+        std::atomic<int> nextMove = 0;
+        std::atomic<bool> cancelled = false;
+        int workers = 0; // guarded by splitMutex
+        int ply;
+        thc::Move previousMove;
+
+        std::mutex mutex; // guards fields below
+        Score alpha;
+        Score beta;
+        thc::Move bestMove;
+        bool improved = false;
+        bool cutoff = false;
+
+        bool isCancelled() const {
+            for (const SplitPoint *splitPoint = this; splitPoint != nullptr; splitPoint = splitPoint->parent) {
+                if (splitPoint->cancelled.load(std::memory_order_relaxed)) {
+                    return true;
+                }
             }
+            return false;
         }
+    };
 
-#ifdef TIME_OUT
-        auto currTime = std::chrono::high_resolution_clock::now();
-        auto algTime = std::chrono::duration_cast<std::chrono::milliseconds>(currTime - minMaxStart);
-        if (algTime.count() > TIME_OUT) {
-            throw TimeOut{};
-        }
-#endif
+    // data owned by single search thread
+    struct SearchState {
+        int currentMaxDepth = 0;
+        thc::Move currBestMove;
+        Score currBestEval = 0;
+        int rootMovesSearched = 0; // in current iteration
+        SplitPoint *splitPoint = nullptr; // innermost split point this thread works for
+        uint64_t nodes = 0;
+        uint64_t nextTimeCheck = 0;
+        bool afterNullMove = false; // node being entered was reached by null move
+        BitboardPosition position; // the same position as searched thc::ChessRules, moves are made on both
 
-        thc::MOVELIST moveList;
-        std::array<HashType, MAXMOVES> nextBoardHashes;
-#ifdef GENERATE_MOVES_WITH_ADDITIONAL_DATA
-        static bool check[MAXMOVES];
-        static bool mate[MAXMOVES];
-        static bool stalemate[MAXMOVES];
-#endif
-#ifdef MOVE_ORDERING
-        static std::array<float, MAXMOVES> movesOrderingWeights;
-        static std::array<int, MAXMOVES> permutation;
-        std::iota(permutation.begin(), permutation.end(), 0);
-        auto calculateMoveWeight = [&](int moveIdx, thc::ChessRules board) -> float {
-            float val = 0.f;
-#ifdef GENERATE_MOVES_WITH_ADDITIONAL_DATA
-            if (mate[moveIdx]) {
-                return 1000.f;
+        // move ordering memory, filled on cut offs by quiet moves
+        int ply = 0; // number of moves (null moves included) made from root
+        std::vector<thc::Move> moveStack; // move made at every ply
+        std::vector<std::array<thc::Move, 2>> killers; // quiet moves which cut off at this ply
+        std::array<std::array<std::array<int, 64>, 64>, 2> history{}; // [black][src][dst]
+        std::array<std::array<thc::Move, 64>, 64> counterMoves; // [previous src][previous dst]
+
+        explicit SearchState(int maxDepth) : moveStack(maxDepth + 1), killers(maxDepth + 1) {
+            for (auto &move: moveStack) {
+                move.Invalid();
             }
-            if (stalemate[moveIdx]) {
-                return 1000.f;
+            for (auto &plyKillers: killers) {
+                plyKillers[0].Invalid();
+                plyKillers[1].Invalid();
             }
-            if (check[moveIdx]) {
-                val += 3.f;
+            for (auto &moves: counterMoves) {
+                for (auto &move: moves) {
+                    move.Invalid();
+                }
             }
+        }
+#ifdef DEBUG_STATS
+        uint64_t evaluationFunctionInvokeCounter = 0;
+        uint64_t hashSkipsCounter = 0;
+        uint64_t alphaBetaCutOffs = 0;
+        uint64_t firstMoveCutOffs = 0;
+        uint64_t pvsResearches = 0;
+        uint64_t aspirationResearches = 0;
+        uint64_t nullMoveCutOffs = 0;
+        uint64_t hashMoveCutOffs = 0;
+        uint64_t lmrResearches = 0;
 #endif
-            thc::Move move = moveList.moves[moveIdx];
-#ifdef HASH_TABLE
-//            auto hashEntry = knownPositions.find(nextBoardHashes[moveIdx]);
-//            if (hashEntry != knownPositions.end()) {
-//                if (hashEntry->second.remainingDepth >= currentMaxDepth - (depth + 1)) {
-//                    if (hashEntry->second.hashFlag == HashFlag::Exact) {
-//                        return 100.f;
-//                    } else {
-//                        return 5.f;
-//                    }
-//                } else {
-//                    if (board.WhiteToPlay()) {
-//                        val += (hashEntry->second.hashFlag == HashFlag::Exact ? 1.f : 0.5f) *
-//                               hashEntry->second.evaluation;
-//                    } else {
-//                        val -= (hashEntry->second.hashFlag == HashFlag::Exact ? 1.f : 0.5f) *
-//                               hashEntry->second.evaluation;
-//                    }
-//                }
-//            }
-#endif
-            if (move.capture) {
-                auto getPieceValue = [&](thc::Square s) {
-                    switch (board.squares[s]) {
-                        case 'P':
-                            return 1;
-                        case 'R':
-                            return 5;
-                        case 'N':
-                            return 3;
-                        case 'B':
-                            return 3;
-                        case 'Q':
-                            return 9;
-                        case 'p':
-                            return 1;
-                        case 'r':
-                            return 5;
-                        case 'n':
-                            return 3;
-                        case 'b':
-                            return 3;
-                        case 'q':
-                            return 9;
-                    }
-                    return 0;
-                };
-                val += std::max(0, std::abs(getPieceValue(move.dst)) -
-                                   std::abs(getPieceValue(move.src)));
-            }
-            if (move.special == thc::SPECIAL_PROMOTION_QUEEN) {
-                val += 8;
-            }
-
+    };
 
-            thc::Square kingSquare;
-            thc::Square myKingSquare;
-            if (board.WhiteToPlay()) {
-                kingSquare = board.bking_square;
-                myKingSquare = board.wking_square;
-            } else {
-                kingSquare = board.wking_square;
-                myKingSquare = board.bking_square;
+    void iterativeDeepening(SearchState &state, thc::ChessRules &board, HashType hash, int firstDepth,
+                            bool mainThread = false) {
+        state.currBestMove.Invalid();
+        state.position.fromChessRules(board);
+        thc::Move lastBestMove = state.currBestMove;
+        Score lastEval = 0;
+        // step larger than maxDepth still searches maxDepth once
+        firstDepth = std::min(firstDepth, maxDepth);
+        for (int depth = firstDepth; depth <= maxDepth; depth += depthStep) {
+            state.currentMaxDepth = depth;
+            if (mainThread) {
+                std::cout << depth << " | ";
             }
-            constexpr static std::array<int, 8> squareOffsets = {-9, -8, -7, -1, 1, 7, 8, 9};
-            for (auto offset: squareOffsets) {
-                if (move.dst == kingSquare + offset) {
-                    val += 0.1f;
-                }
-                if (move.src == kingSquare + offset) {
-                    val -= 0.1f;
-                }
-                if (move.dst == myKingSquare + offset) {
-                    val += 0.1f /2.f;
+            state.rootMovesSearched = 0;
+            Score eval = depth == firstDepth ? minMax(state, board, hash, 0)
+                                             : aspirationSearch(state, board, hash, lastEval);
+            if (aborted(state)) {
+                // unfinished iteration searched previous best move first, so its best move is not worse
+                if (mainThread && state.rootMovesSearched > 0) {
+                    std::lock_guard<std::mutex> lock(resultMutex);
+                    if (depth > completedDepth) {
+                        bestMove = state.currBestMove;
+                        bestEval = state.currBestEval;
+                    }
                 }
-                if (move.src == myKingSquare + offset) {
-                    val -= 0.1f /2.f;
+                break;
+            }
+            // result of the deepest finished iteration wins, no matter which thread finished it
+            {
+                std::lock_guard<std::mutex> lock(resultMutex);
+                if (depth > completedDepth) {
+                    completedDepth = depth;
+                    bestMove = state.currBestMove;
+                    bestEval = eval;
                 }
             }
-
-            static constexpr float boardPositionWeightDivisor = 300.f;
-            switch (board.squares[move.src]) {
-                case 'P':
-                    val += (pawnsOnBoardPositions[move.dst] - pawnsOnBoardPositions[move.src]) /
-                           boardPositionWeightDivisor;
-                    break;
-                case 'R':
-                    val += (rookOnBoardPositions[move.dst] - rookOnBoardPositions[move.src]) /
-                           boardPositionWeightDivisor;
-                    break;
-                case 'N':
-                    val += (knightsOnBoardPositions[move.dst] - knightsOnBoardPositions[move.src]) /
-                           boardPositionWeightDivisor;
-                    break;
-                case 'B':
-                    val += (bishopsOnBoardPositions[move.dst] - bishopsOnBoardPositions[move.src]) /
-                           boardPositionWeightDivisor;
-                    break;
-                case 'Q':
-                    val += (queenOnBoardPositions[move.dst] - queenOnBoardPositions[move.src]) /
-                           boardPositionWeightDivisor;
-                    break;
-                case 'K':
-                    val += (kingOnBoardPositions[move.dst] - kingOnBoardPositions[move.src]) /
-                           boardPositionWeightDivisor;
-                    break;
-
-                    // black
-                case 'p':
-                    val += (pawnsOnBoardPositions[63 - move.dst] - pawnsOnBoardPositions[63 - move.src]) /
-                           boardPositionWeightDivisor;
-                    break;
-                case 'r':
-                    val += (rookOnBoardPositions[63 - move.dst] - rookOnBoardPositions[63 - move.src]) /
-                           boardPositionWeightDivisor;
-                    break;
-                case 'n':
-                    val += (knightsOnBoardPositions[63 - move.dst] - knightsOnBoardPositions[63 - move.src]) /
-                           boardPositionWeightDivisor;
-                    break;
-                case 'b':
-                    val += (bishopsOnBoardPositions[63 - move.dst] - bishopsOnBoardPositions[63 - move.src]) /
-                           boardPositionWeightDivisor;
-                    break;
-                case 'q':
-                    val += (queenOnBoardPositions[63 - move.dst] - queenOnBoardPositions[63 - move.src]) /
-                           boardPositionWeightDivisor;
-                    break;
-                case 'k':
-                    val += (kingOnBoardPositions[63 - move.dst] - kingOnBoardPositions[63 - move.src]) /
-                           boardPositionWeightDivisor;
-                    break;
+            // deeper search cannot find shorter mate
+            if (isMate(eval)) {
+                break;
             }
+            if (mainThread && !timeManager.startNextIteration(lastBestMove.Valid() &&
+                                                              lastBestMove != state.currBestMove)) {
+                break;
+            }
+            lastBestMove = state.currBestMove;
+            lastEval = eval;
+        }
+    }
 
-
-            return val;
-        };
+    // root search with window around previous iteration's evaluation, widened when result falls outside of it
+    Score aspirationSearch(SearchState &state, thc::ChessRules &board, HashType hash, Score expectedEval) {
+        Score delta = aspirationWindow;
+        Score alpha = expectedEval - delta;
+        Score beta = expectedEval + delta;
+        while (true) {
+            Score eval = minMax(state, board, hash, 0, alpha, beta);
+            if (aborted(state) || (eval > alpha && eval < beta)) {
+                return eval;
+            }
+            delta *= 4;
+            if (eval <= alpha) {
+                alpha = delta > maxAspirationWindow ? -infinity : expectedEval - delta;
+            } else {
+                beta = delta > maxAspirationWindow ? infinity : expectedEval + delta;
+            }
+#ifdef DEBUG_STATS
+            state.aspirationResearches++;
 #endif
+        }
+    }
 
-#ifdef GENERATE_MOVES_WITH_ADDITIONAL_DATA
-        board.GenLegalMoveList(&moveList, check, mate, stalemate);
-#else
-        board.GenLegalMoveList(&moveList);
+    Score minMax(SearchState &state, thc::ChessRules &board, HashType boardHash, int depth, Score alpha = -infinity,
+                 Score beta = infinity) {
+#ifdef HASH_TABLE
+        auto insertBoardToHashTable = [this, &state](HashType hash, Score val, HashFlag hashFlag, int depth,
+                                             thc::Move bestMove) {
+            knownPositions.store(hash, state.currentMaxDepth - depth, toHashScore(val, state.ply), hashFlag,
+                                 bestMove);
+        };
+        thc::Move nodeBestMove{};
+        nodeBestMove.Invalid();
+        HashFlag hashFlag = HashFlag::Exact;
+        if (board.WhiteToPlay()) {
+            hashFlag = HashFlag::Beta;
+        } else {
+            hashFlag = HashFlag::Alpha;
+        }
 #endif
-        // calculate board hashes
-        for (int i = 0; i < moveList.count; i++) {
-            auto &move = moveList.moves[i];
-            board.PushMove(move);
 
-            // TODO
-            auto newHash = updateHash(board, boardHash, move);
-            nextBoardHashes[i] = newHash;
-            board.PopMove(move);
-        }
-#ifdef MOVE_ORDERING
-        //calculate moves weights
-        for (int i = 0; i < moveList.count; i++) {
-            auto &move = moveList.moves[i];
-            movesOrderingWeights[i] = calculateMoveWeight(i, board);
+        bool afterNullMove = state.afterNullMove;
+        state.afterNullMove = false;
+        thc::Move previousMove;
+        if (state.ply > 0) {
+            previousMove = state.moveStack[state.ply - 1];
+        } else {
+            previousMove.Invalid();
         }
-        //sort moves based on weights
-        std::sort(permutation.begin(), std::next(permutation.begin(), moveList.count), [&](int idx1, int idx2) {
-            return movesOrderingWeights[idx1] > movesOrderingWeights[idx2];
-        });
-        //apply permutation
-        for (int i = 0; i < moveList.count; i++) {
-            thc::Move t = moveList.moves[i];
-            auto hash = nextBoardHashes[i];
-            auto current = i;
-            while (i != permutation[current]) {
-                auto next = permutation[current];
-                moveList.moves[current] = moveList.moves[next];
-                nextBoardHashes[current] = nextBoardHashes[next];
-                permutation[current] = current;
-                current = next;
-            }
-            moveList.moves[current] = t;
-            nextBoardHashes[current] = hash;
-            permutation[current] = current;
+
+#ifdef ANTY_3_FOLD_REPETITION
+        if (depth > 0 && gameHistory.contains(boardHash)) {
+            return 0;
         }
 #endif
+        countNode(state);
 
-        for (int i = 0; i < moveList.count; i++) {
-            auto &move = moveList.moves[i];
+        // mate and stalemate are found without generating moves twice: at the horizon by looking for any legal move
+        // (it usually stops at the first king move), before it when move picker gives no move
+        if (depth == state.currentMaxDepth) {
+            if (!state.position.hasLegalMove()) {
+                return terminalEvaluation(state.position, state.ply);
+            }
+#ifdef QUIESCENCE_SEARCH
+            return quiescence(state, board, alpha, beta);
+#else
+            Score eval = evaluationFunction(state.position);
+#ifdef DEBUG_STATS
+            state.evaluationFunctionInvokeCounter++;
+#endif
+            return eval;
+#endif
+        }
 
+        if (aborted(state)) {
+            return 0;
+        }
 
-            board.PushMove(move);
+        bool white = board.WhiteToPlay();
+        bool inCheck = state.position.inCheck();
+        // two null moves in a row would only waste depth, in check passing is illegal and with pawns only
+        // zugzwang is too common to trust it
+        if (nullMovePruning && depth > 0 && !afterNullMove && !inCheck &&
+            state.currentMaxDepth - depth >= minNullMoveDepth && state.position.hasPieces(white) &&
+            (white ? beta < infinity : alpha > -infinity)) {
+            Score nullMoveEval = searchNullMove(state, board, boardHash, depth, alpha, beta);
+            if (aborted(state)) {
+                return 0;
+            }
+            if (white ? nullMoveEval >= beta : nullMoveEval <= alpha) {
 #ifdef HASH_TABLE
-            float new_val;
-            auto hashEntry = knownPositions.find(nextBoardHashes[i]);
-            if (hashEntry != knownPositions.end() &&
-                hashEntry->second.remainingDepth >= currentMaxDepth - (depth + 1) &&
-                hashEntry->second.hashFlag == HashFlag::Exact) {
-#ifdef DEBUG_STATS
-                hashSkipsCounter++;
+                insertBoardToHashTable(boardHash, white ? beta : alpha, white ? HashFlag::Alpha : HashFlag::Beta,
+                                       depth, nodeBestMove);
 #endif
-                new_val = hashEntry->second.evaluation;
-            } else if (hashEntry != knownPositions.end() &&
-                       hashEntry->second.remainingDepth >= currentMaxDepth - (depth + 1) &&
-                       hashEntry->second.hashFlag == HashFlag::Beta && hashEntry->second.evaluation <= alpha) {
 #ifdef DEBUG_STATS
-                hashSkipsCounter++;
+                state.nullMoveCutOffs++;
 #endif
-                new_val = hashEntry->second.evaluation;
-            } else if (hashEntry != knownPositions.end() &&
-                       hashEntry->second.remainingDepth >= currentMaxDepth - (depth + 1) &&
-                       hashEntry->second.hashFlag == HashFlag::Alpha && hashEntry->second.evaluation >= beta) {
-#ifdef DEBUG_STATS
-                hashSkipsCounter++;
+                return white ? beta : alpha;
+            }
+        }
+
+        // moves come from MovePicker stage after stage, the first one is hash move (at root best move of previous
+        // iteration), when it cuts off, other moves are never generated
+        thc::Move hashMove;
+        hashMove.Invalid();
+        if (depth == 0 && state.currBestMove.Valid()) {
+            hashMove = state.currBestMove;
+        }
+#ifdef HASH_TABLE
+        HashEntry hashEntry;
+        if (!hashMove.Valid() && knownPositions.probe(boardHash, hashEntry)) {
+            hashMove = hashEntry.bestMove;
+        }
 #endif
-                new_val = hashEntry->second.evaluation;
+        thc::Move counterMove;
+        if (previousMove.Valid()) {
+            counterMove = state.counterMoves[previousMove.src][previousMove.dst];
+        } else {
+            counterMove.Invalid();
+        }
+        MovePicker movePicker(board, state.position, hashMove, state.killers[state.ply], counterMove,
+                              state.history[white ? 0 : 1], moveOrdering);
+
+        int i = 0; // moves searched so far
+        bool anyMove = false;
+        thc::Move move;
+        while (movePicker.next(move)) {
+            anyMove = true;
+            HashType nextBoardHash = updateHash(board, boardHash, move);
+#ifdef DEBUG_HASH
+            checkHash(board, nextBoardHash, move);
+#endif
+            bool reduce = lateMoveReductions && depth > 0 && i >= lmrFullDepthMoves && !inCheck &&
+                          state.currentMaxDepth - depth >= minLmrDepth && MovePicker::isQuiet(move);
+            board.PushMove(move);
+            state.position.pushMove(move);
+            state.moveStack[state.ply++] = move;
+            Score new_val;
+            if (i == 0) {
+                new_val = searchChild(state, board, nextBoardHash, depth + 1, alpha, beta);
+            } else if (reduce && !state.position.inCheck()) {
+                new_val = searchChildLmr(state, board, nextBoardHash, depth + 1, alpha, beta);
             } else {
-                new_val = minMax(board, nextBoardHashes[i], depth + 1, alpha, beta);
+                new_val = searchChildPvs(state, board, nextBoardHash, depth + 1, alpha, beta);
             }
-#else
-            float new_val = minMax(board, nextBoardHashes[i], depth + 1, alpha, beta);
-#endif
+            state.ply--;
             board.PopMove(move);
-
+            state.position.popMove(move);
+            if (aborted(state)) {
+                return 0;
+            }
 
             if (board.WhiteToPlay()) {
                 if (new_val >= beta) {
 #ifdef HASH_TABLE
-                    insertBoardToHashTable(boardHash, beta, HashFlag::Alpha, depth);
+                    insertBoardToHashTable(boardHash, beta, HashFlag::Alpha, depth, move);
 #endif
+                    if (depth == 0) {
+                        state.currBestMove = move;
+                        state.currBestEval = beta;
+                    }
+                    if (MovePicker::isQuiet(move)) {
+                        recordCutOff(state, board, move, previousMove, state.currentMaxDepth - depth);
+                    }
 #ifdef DEBUG_STATS
-                    alphaBetaCutOffs++;
+                    state.alphaBetaCutOffs++;
+                    if (i == 0) {
+                        state.firstMoveCutOffs++;
+                    }
+                    if (!movePicker.movesGenerated()) {
+                        state.hashMoveCutOffs++;
+                    }
 #endif
                     return beta;
                 }
                 if (new_val > alpha) {
 #ifdef HASH_TABLE
                     hashFlag = HashFlag::Exact;
+                    nodeBestMove = move;
 #endif
                     alpha = new_val;
                     if(depth == 0){
-                        currBestMove = move;
+                        state.currBestMove = move;
+                        state.currBestEval = new_val;
                     }
                 }
             } else {
                 if (new_val <= alpha) {
 #ifdef HASH_TABLE
-                    insertBoardToHashTable(boardHash, alpha, HashFlag::Beta, depth);
+                    insertBoardToHashTable(boardHash, alpha, HashFlag::Beta, depth, move);
 #endif
+                    if (depth == 0) {
+                        state.currBestMove = move;
+                        state.currBestEval = alpha;
+                    }
+                    if (MovePicker::isQuiet(move)) {
+                        recordCutOff(state, board, move, previousMove, state.currentMaxDepth - depth);
+                    }
 #ifdef DEBUG_STATS
-                    alphaBetaCutOffs++;
+                    state.alphaBetaCutOffs++;
+                    if (i == 0) {
+                        state.firstMoveCutOffs++;
+                    }
+                    if (!movePicker.movesGenerated()) {
+                        state.hashMoveCutOffs++;
+                    }
 #endif
                     return alpha;
                 }
                 if (new_val < beta) {
 #ifdef HASH_TABLE
                     hashFlag = HashFlag::Exact;
+                    nodeBestMove = move;
 #endif
                     beta = new_val;
                     if(depth == 0){
-                        currBestMove = move;
+                        state.currBestMove = move;
+                        state.currBestEval = new_val;
+                    }
+                }
+            }
+            if (depth == 0) {
+                state.rootMovesSearched++;
+            }
+
+            if (i == 0 && parallelMode == ParallelMode::Ybwc && threadsCount > 1 &&
+                state.currentMaxDepth - depth >= minSplitDepth) {
+                // split point needs all remaining moves
+                thc::MOVELIST splitMoves;
+                splitMoves.count = 0;
+                while (movePicker.next(splitMoves.moves[splitMoves.count])) {
+                    splitMoves.count++;
+                }
+                if (splitMoves.count > 0) {
+                    SplitPoint splitPoint(state.splitPoint, board, state.position, boardHash, depth,
+                                          state.currentMaxDepth, splitMoves.moves, splitMoves.count, state.ply,
+                                          previousMove, alpha, beta);
+                    splitSearch(state, splitPoint);
+                    alpha = splitPoint.alpha;
+                    beta = splitPoint.beta;
+                    if (splitPoint.improved && !splitPoint.cutoff) {
+#ifdef HASH_TABLE
+                        hashFlag = HashFlag::Exact;
+                        nodeBestMove = splitPoint.bestMove;
+#endif
+                        if (depth == 0) {
+                            state.currBestMove = splitPoint.bestMove;
+                            state.currBestEval = board.WhiteToPlay() ? alpha : beta;
+                        }
                     }
+                    if (aborted(state)) {
+                        return 0;
+                    }
+                    if (depth == 0) {
+                        state.rootMovesSearched += splitMoves.count;
+                    }
+                    if (splitPoint.cutoff) {
+#ifdef HASH_TABLE
+                        insertBoardToHashTable(boardHash, board.WhiteToPlay() ? beta : alpha,
+                                               board.WhiteToPlay() ? HashFlag::Alpha : HashFlag::Beta, depth,
+                                               splitPoint.bestMove);
+#endif
+                        // root fail high (aspiration window) is searched first again, as in serial search
+                        if (depth == 0) {
+                            state.currBestMove = splitPoint.bestMove;
+                            state.currBestEval = board.WhiteToPlay() ? beta : alpha;
+                        }
+                        return board.WhiteToPlay() ? beta : alpha;
+                    }
+                    break;
                 }
             }
+            i++;
+        }
+        if (!anyMove) {
+            return terminalEvaluation(state.position, state.ply);
         }
 #ifdef HASH_TABLE
-        insertBoardToHashTable(boardHash, board.WhiteToPlay() ? alpha : beta, hashFlag, depth);
+        insertBoardToHashTable(boardHash, board.WhiteToPlay() ? alpha : beta, hashFlag, depth, nodeBestMove);
 #endif
         return board.WhiteToPlay() ? alpha : beta;
     }
 
+    // side to move has no legal move: mate or stalemate, ply is distance from root
+    static Score terminalEvaluation(const BitboardPosition &position, int ply) {
+        if (!position.inCheck()) {
+            return 0;
+        }
+        return position.whiteToPlay() ? -(mateScore - ply) : mateScore - ply;
+    }
+
+    // transposition table keeps mate scores as distance from the stored node, not from root, so they stay valid
+    // when the node is reached at other ply
+    static Score toHashScore(Score score, int ply) {
+        if (!isMate(score)) {
+            return score;
+        }
+        return score > 0 ? score + ply : score - ply;
+    }
+
+    static Score fromHashScore(Score score, int ply) {
+        if (!isMate(score)) {
+            return score;
+        }
+        return score > 0 ? score - ply : score + ply;
+    }
+
+#ifdef QUIESCENCE_SEARCH
+    // margin for delta pruning, capture which cannot raise evaluation above alpha even with it is skipped
+    constexpr static Score deltaMargin = 200;
+
+    // searches only captures and promotions below the horizon, so position is evaluated when it is quiet
+    Score quiescence(SearchState &state, thc::ChessRules &board, Score alpha, Score beta) {
+        countNode(state);
+        Score standPat = evaluationFunction(state.position);
+#ifdef DEBUG_STATS
+        state.evaluationFunctionInvokeCounter++;
+#endif
+        bool white = board.WhiteToPlay();
+        if (white) {
+            if (standPat >= beta) {
+                return beta;
+            }
+            alpha = std::max(alpha, standPat);
+        } else {
+            if (standPat <= alpha) {
+                return alpha;
+            }
+            beta = std::min(beta, standPat);
+        }
+
+        thc::MOVELIST moveList;
+        state.position.genLegalTacticalMoves(&moveList);
+
+        // MVV-LVA: most valuable victim first, least valuable attacker breaks ties
+        std::array<std::pair<int, int>, MAXMOVES> tacticalMoves;
+        int tacticalMovesCount = 0;
+        for (int i = 0; i < moveList.count; i++) {
+            auto &move = moveList.moves[i];
+            int gain = MovePicker::pieceValue(char(move.capture)) + MovePicker::promotionGain(move.special);
+            if (gain == 0) {
+                continue;
+            }
+            // delta pruning
+            Score maxGain = gain * 100 + deltaMargin;
+            if (white ? standPat + maxGain < alpha : standPat - maxGain > beta) {
+                continue;
+            }
+            tacticalMoves[tacticalMovesCount++] = {gain * 10 - MovePicker::pieceValue(board.squares[move.src]), i};
+        }
+        std::sort(tacticalMoves.begin(), std::next(tacticalMoves.begin(), tacticalMovesCount),
+                  [](const auto &move1, const auto &move2) { return move1.first > move2.first; });
+
+        for (int i = 0; i < tacticalMovesCount; i++) {
+            auto &move = moveList.moves[tacticalMoves[i].second];
+            board.PushMove(move);
+            state.position.pushMove(move);
+            Score new_val = quiescence(state, board, alpha, beta);
+            board.PopMove(move);
+            state.position.popMove(move);
+            if (white) {
+                if (new_val >= beta) {
+                    return beta;
+                }
+                alpha = std::max(alpha, new_val);
+            } else {
+                if (new_val <= alpha) {
+                    return alpha;
+                }
+                beta = std::min(beta, new_val);
+            }
+        }
+        return white ? alpha : beta;
+    }
+#endif
+
+    // value of position after move, taken from transposition table when stored result is deep enough
+    Score searchChild(SearchState &state, thc::ChessRules &board, HashType hash, int depth, Score alpha,
+                      Score beta) {
+#ifdef HASH_TABLE
+        HashEntry hashEntry;
+        bool hashEntryFound = knownPositions.probe(hash, hashEntry) &&
+                              hashEntry.remainingDepth >= state.currentMaxDepth - depth;
+        Score hashEval = hashEntryFound ? fromHashScore(hashEntry.evaluation, state.ply) : 0;
+        if (hashEntryFound && hashEntry.hashFlag == HashFlag::Exact) {
+#ifdef DEBUG_STATS
+            state.hashSkipsCounter++;
+#endif
+            return hashEval;
+        } else if (hashEntryFound && hashEntry.hashFlag == HashFlag::Beta && hashEval <= alpha) {
+#ifdef DEBUG_STATS
+            state.hashSkipsCounter++;
+#endif
+            return hashEval;
+        } else if (hashEntryFound && hashEntry.hashFlag == HashFlag::Alpha && hashEval >= beta) {
+#ifdef DEBUG_STATS
+            state.hashSkipsCounter++;
+#endif
+            return hashEval;
+        }
+#endif
+        return minMax(state, board, hash, depth, alpha, beta);
+    }
+
+    // principal variation search for moves after the first one: null window only proves that move is not better,
+    // when it fails, move is searched again with full window
+    Score searchChildPvs(SearchState &state, thc::ChessRules &board, HashType hash, int depth, Score alpha,
+                         Score beta) {
+        if (beta - alpha <= nullWindow) {
+            return searchChild(state, board, hash, depth, alpha, beta);
+        }
+        bool whiteMoved = !board.WhiteToPlay();
+        Score new_val;
+        if (whiteMoved) {
+            new_val = searchChild(state, board, hash, depth, alpha, alpha + nullWindow);
+            if (new_val <= alpha || new_val >= beta) {
+                return new_val;
+            }
+        } else {
+            new_val = searchChild(state, board, hash, depth, beta - nullWindow, beta);
+            if (new_val >= beta || new_val <= alpha) {
+                return new_val;
+            }
+        }
+        if (aborted(state)) {
+            return new_val;
+        }
+#ifdef DEBUG_STATS
+        state.pvsResearches++;
+#endif
+        return searchChild(state, board, hash, depth, alpha, beta);
+    }
+
+    // late move reduction: null window search with reduced depth, move which beats the bound is searched again
+    // with full depth
+    Score searchChildLmr(SearchState &state, thc::ChessRules &board, HashType hash, int depth, Score alpha,
+                         Score beta) {
+        int reducedDepth = std::min(depth + lmrReduction, state.currentMaxDepth);
+        bool whiteMoved = !board.WhiteToPlay();
+        Score new_val = whiteMoved ? searchChild(state, board, hash, reducedDepth, alpha, alpha + nullWindow)
+                                   : searchChild(state, board, hash, reducedDepth, beta - nullWindow, beta);
+        if (aborted(state) || (whiteMoved ? new_val <= alpha : new_val >= beta)) {
+            return new_val;
+        }
+#ifdef DEBUG_STATS
+        state.lmrResearches++;
+#endif
+        return searchChildPvs(state, board, hash, depth, alpha, beta);
+    }
+
+    // side to move passes, null window around the bound it would have to beat, depth is reduced
+    Score searchNullMove(SearchState &state, thc::ChessRules &board, HashType boardHash, int depth, Score alpha,
+                         Score beta) {
+        bool white = board.WhiteToPlay();
+        HashType hash = board.Hash64UpdateNullMove(boardHash);
+        int reducedDepth = std::min(depth + 1 + nullMoveReduction, state.currentMaxDepth);
+        board.PushNullMove();
+        state.position.pushNullMove();
+        state.moveStack[state.ply++].Invalid();
+#ifdef DEBUG_HASH
+        if (hash != calculateHash(board)) {
+            std::cerr << "Null move hash mismatch: " << board.ForsythPublish() << "\n";
+            std::abort();
+        }
+#endif
+        state.afterNullMove = true;
+        Score eval = white ? searchChild(state, board, hash, reducedDepth, beta - nullWindow, beta)
+                           : searchChild(state, board, hash, reducedDepth, alpha, alpha + nullWindow);
+        state.afterNullMove = false;
+        state.ply--;
+        board.PopNullMove();
+        state.position.popNullMove();
+        return eval;
+    }
+
+    // quiet move cut off: it becomes killer of this ply, counter move of previous move and its history grows with
+    // square of remaining depth
+    static void recordCutOff(SearchState &state, const thc::ChessRules &board, thc::Move move,
+                             thc::Move previousMove, int remainingDepth) {
+        auto &killers = state.killers[state.ply];
+        if (!(killers[0] == move)) {
+            killers[1] = killers[0];
+            killers[0] = move;
+        }
+        int &history = state.history[board.WhiteToPlay() ? 0 : 1][move.src][move.dst];
+        history = std::min(history + remainingDepth * remainingDepth, maxHistory);
+        if (previousMove.Valid()) {
+            state.counterMoves[previousMove.src][previousMove.dst] = move;
+        }
+    }
+
+    // searches remaining moves of split point together with idle threads, returns when all of them finished
+    void splitSearch(SearchState &state, SplitPoint &splitPoint) {
+        {
+            std::lock_guard<std::mutex> lock(splitMutex);
+            splitPoints.push_back(&splitPoint);
+        }
+        splitCondition.notify_all();
+
+        searchSplitPoint(state, splitPoint);
+
+        std::unique_lock<std::mutex> lock(splitMutex);
+        splitCondition.wait(lock, [&] { return splitPoint.workers == 0; });
+        splitPoints.erase(std::find(splitPoints.begin(), splitPoints.end(), &splitPoint));
+    }
+
+    // takes moves from split point until there are none left, used by owner of split point and by helpers
+    void searchSplitPoint(SearchState &state, SplitPoint &splitPoint) {
+        SplitPoint *previousSplitPoint = state.splitPoint;
+        int previousMaxDepth = state.currentMaxDepth;
+        int previousPly = state.ply;
+        thc::Move previousPlyMove = state.moveStack[std::max(splitPoint.ply - 1, 0)];
+        BitboardPosition previousPosition = state.position;
+        state.splitPoint = &splitPoint;
+        state.currentMaxDepth = splitPoint.currentMaxDepth;
+        state.ply = splitPoint.ply;
+        if (splitPoint.ply > 0) {
+            state.moveStack[splitPoint.ply - 1] = splitPoint.previousMove;
+        }
+        thc::ChessRules board = splitPoint.board;
+        state.position = splitPoint.position;
+        for (int i = splitPoint.nextMove++; i < splitPoint.movesCount; i = splitPoint.nextMove++) {
+            thc::Move move = splitPoint.moves[i];
+            Score alpha;
+            Score beta;
+            {
+                std::lock_guard<std::mutex> lock(splitPoint.mutex);
+                alpha = splitPoint.alpha;
+                beta = splitPoint.beta;
+            }
+            HashType nextBoardHash = updateHash(board, splitPoint.boardHash, move);
+            board.PushMove(move);
+            state.position.pushMove(move);
+            state.moveStack[state.ply++] = move;
+            Score new_val = searchChildPvs(state, board, nextBoardHash, splitPoint.depth + 1, alpha, beta);
+            state.ply--;
+            board.PopMove(move);
+            state.position.popMove(move);
+            if (aborted(state)) {
+                break;
+            }
+
+            std::lock_guard<std::mutex> lock(splitPoint.mutex);
+            if (splitPoint.cutoff) {
+                break;
+            }
+            if (board.WhiteToPlay() ? new_val >= splitPoint.beta : new_val <= splitPoint.alpha) {
+                splitPoint.cutoff = true;
+                splitPoint.bestMove = move;
+                splitPoint.cancelled = true;
+                if (MovePicker::isQuiet(move)) {
+                    recordCutOff(state, board, move, splitPoint.previousMove,
+                                 splitPoint.currentMaxDepth - splitPoint.depth);
+                }
+#ifdef DEBUG_STATS
+                state.alphaBetaCutOffs++;
+#endif
+                break;
+            }
+            if (board.WhiteToPlay() && new_val > splitPoint.alpha) {
+                splitPoint.alpha = new_val;
+                splitPoint.bestMove = move;
+                splitPoint.improved = true;
+            } else if (!board.WhiteToPlay() && new_val < splitPoint.beta) {
+                splitPoint.beta = new_val;
+                splitPoint.bestMove = move;
+                splitPoint.improved = true;
+            }
+        }
+        state.splitPoint = previousSplitPoint;
+        state.currentMaxDepth = previousMaxDepth;
+        state.ply = previousPly;
+        state.position = previousPosition;
+        if (splitPoint.ply > 0) {
+            state.moveStack[splitPoint.ply - 1] = previousPlyMove;
+        }
+    }
+
+    // helper thread in ParallelMode::Ybwc, joins split points until search is stopped
+    void splitWorker(SearchState &state) {
+        std::unique_lock<std::mutex> lock(splitMutex);
+        while (true) {
+            SplitPoint *splitPoint = nullptr;
+            splitCondition.wait(lock, [&] {
+                if (stopSearch) {
+                    return true;
+                }
+                for (auto candidate: splitPoints) {
+                    if (candidate->nextMove < candidate->movesCount && !candidate->isCancelled()) {
+                        splitPoint = candidate;
+                        return true;
+                    }
+                }
+                return false;
+            });
+            if (stopSearch) {
+                return;
+            }
+            splitPoint->workers++;
+            lock.unlock();
+            searchSplitPoint(state, *splitPoint);
+            lock.lock();
+            splitPoint->workers--;
+            splitCondition.notify_all();
+        }
+    }
+
+    // search is stopped or result of this thread's split point is not needed anymore
+    bool aborted(const SearchState &state) const {
+        return stopSearch.load(std::memory_order_relaxed) ||
+               (state.splitPoint != nullptr && state.splitPoint->isCancelled());
+    }
+
+    void countNode(SearchState &state) {
+        if (++state.nodes >= state.nextTimeCheck) {
+            state.nextTimeCheck = state.nodes + nodesBetweenTimeChecks;
+            checkTime();
+        }
+    }
+
+    void checkTime() {
+        if (timeManager.hardLimitReached()) {
+            stopSearch = true;
+        }
+    }
+
     HashType calculateHash(thc::ChessRules &board) {
-        uint32_t metaData = uint32_t(board.enpassant_target);
-        metaData += uint32_t(board.WhiteToPlay()) << 10;
-        metaData += uint32_t(board.wking_allowed()) << 11;
-        metaData += uint32_t(board.wqueen_allowed()) << 12;
-        metaData += uint32_t(board.bking_allowed()) << 13;
-        metaData += uint32_t(board.bqueen_allowed()) << 14;
-        return {board.Hash64Calculate(), metaData};
+        return board.Hash64Calculate();
     }
 
+    // board is position before the move is made (Hash64Update reads pieces from their original squares)
     HashType updateHash(thc::ChessRules &board, HashType hashToUpdate, thc::Move move) {
-        uint32_t metaData = uint32_t(board.enpassant_target);
-        metaData += uint32_t(board.WhiteToPlay()) << 10;
-        metaData += uint32_t(board.wking_allowed()) << 11;
-        metaData += uint32_t(board.wqueen_allowed()) << 12;
-        metaData += uint32_t(board.bking_allowed()) << 13;
-        metaData += uint32_t(board.bqueen_allowed()) << 14;
-        //TODO
-        return {board.Hash64Calculate(), metaData};
-        return {board.Hash64Update(hashToUpdate.first, move), metaData};
-    }
-
-    KnownPositionsType knownPositions;
-    thc::Move bestMove;
-    thc::Move currBestMove;
+        return board.Hash64Update(hashToUpdate, move);
+    }
+
+#ifdef DEBUG_HASH
 
-    std::function<float(thc::ChessRules &board)> evaluationFunction;
+    void checkHash(thc::ChessRules &board, HashType hash, thc::Move move) {
+        board.PushMove(move);
+        HashType expected = calculateHash(board);
+        board.PopMove(move);
+        if (hash != expected) {
+            std::cerr << "Incremental hash mismatch: " << board.ForsythPublish() << " move: " << move.TerseOut()
+                      << "\n";
+            std::abort();
+        }
+    }
+
+#endif
+
+    Evaluator evaluationFunction;
     int maxDepth;
-    int currentMaxDepth;
 
-    std::chrono::time_point<std::chrono::steady_clock> minMaxStart;
+    int threadsCount = 1;
+    int depthStep = 1;
+    bool nullMovePruning = true;
+    bool lateMoveReductions = true;
+    TimeManager timeManager;
+    ParallelMode parallelMode = ParallelMode::LazySmp;
+    uint64_t lastSearchNodes = 0;
+
+    TranspositionTable knownPositions;
+
+    std::mutex resultMutex;
+    thc::Move bestMove;
+    Score bestEval = 0;
+    int completedDepth = 0;
+    std::atomic<bool> stopSearch = false;
+
+    std::mutex splitMutex;
+    std::condition_variable splitCondition;
+    std::vector<SplitPoint *> splitPoints;
+
 
 #ifdef ANTY_3_FOLD_REPETITION
-    std::unordered_set<HashType, PairHash> gameHistory;
+    std::unordered_set<HashType> gameHistory;
 #endif
 
 
@@ -517,5 +1108,11 @@ private:
     uint64_t evaluationFunctionInvokeCounter = 0;
     uint64_t hashSkipsCounter = 0;
     uint64_t alphaBetaCutOffs = 0;
+    uint64_t firstMoveCutOffs = 0;
+    uint64_t pvsResearches = 0;
+    uint64_t aspirationResearches = 0;
+    uint64_t nullMoveCutOffs = 0;
+    uint64_t hashMoveCutOffs = 0;
+    uint64_t lmrResearches = 0;
 #endif
 };
@@ -0,0 +1,290 @@
+#pragma once
+
+#include <array>
+#include "chess_rules/thc.h"
+#include "BitboardPosition.h"
+#include "ChessBoardWeights.h"
+
+// Gives moves of one node lazily, stage after stage: hash move, winning captures (and promotions), killers, counter
+// move, quiet moves, losing captures. Moves are generated only when the hash move did not cut off and every stage is
+// scored only when search gets to it, so cut nodes do not pay for moves they never search.
+// Moves are generated from bitboards of the same position and all of them are legal.
+class MovePicker {
+public:
+    using History = std::array<std::array<int, 64>, 64>; // [src][dst] of side to move
+
+    // ordering = false gives hash move first and other moves in generation order
+    MovePicker(thc::ChessRules &board_, BitboardPosition &position_, thc::Move hashMove_,
+               const std::array<thc::Move, 2> &killers_, thc::Move counterMove_, const History &history_,
+               bool ordering_) : board{board_},
+                                 position{position_},
+                                 hashMove{hashMove_},
+                                 counterMove{counterMove_},
+                                 history{history_},
+                                 ordering{ordering_} {
+        killers[0] = killers_[0];
+        killers[1] = killers_[1];
+    }
+
+    // false when there are no moves left
+    bool next(thc::Move &move) {
+        while (true) {
+            switch (stage) {
+                case Stage::HashMove:
+                    stage = Stage::Generate;
+                    if (hashMove.Valid() && position.legalMove(hashMove)) {
+                        move = hashMove;
+                        return true;
+                    }
+                    hashMove.Invalid();
+                    break;
+                case Stage::Generate:
+                    generate();
+                    stage = ordering ? Stage::WinningCaptures : Stage::Remaining;
+                    break;
+                case Stage::WinningCaptures:
+                    if (current < winningCapturesEnd) {
+                        move = moves.moves[pickBest(current++, winningCapturesEnd)];
+                        return true;
+                    }
+                    stage = Stage::Killers;
+                    break;
+                case Stage::Killers:
+                    while (killerIndex < 3) {
+                        thc::Move candidate = killerIndex < 2 ? killers[killerIndex] : counterMove;
+                        killerIndex++;
+                        if (takeQuiet(candidate)) {
+                            move = candidate;
+                            return true;
+                        }
+                    }
+                    stage = Stage::Quiets;
+                    scoreQuiets();
+                    current = quietsBegin;
+                    break;
+                case Stage::Quiets:
+                    if (current < quietsEnd) {
+                        move = moves.moves[pickBest(current++, quietsEnd)];
+                        return true;
+                    }
+                    stage = Stage::LosingCaptures;
+                    current = losingCapturesBegin;
+                    break;
+                case Stage::LosingCaptures:
+                    if (current < moves.count) {
+                        move = moves.moves[pickBest(current++, moves.count)];
+                        return true;
+                    }
+                    stage = Stage::Done;
+                    break;
+                case Stage::Remaining:
+                    if (current < moves.count) {
+                        move = moves.moves[current++];
+                        return true;
+                    }
+                    stage = Stage::Done;
+                    break;
+                case Stage::Done:
+                    return false;
+            }
+        }
+    }
+
+    // moves other than hash move were generated
+    bool movesGenerated() const {
+        return stage != Stage::HashMove && stage != Stage::Generate;
+    }
+
+    static bool isQuiet(const thc::Move &move) {
+        return move.capture == ' ' && promotionGain(move.special) == 0;
+    }
+
+    static bool sameMove(const thc::Move &move1, const thc::Move &move2) {
+        return move1.src == move2.src && move1.dst == move2.dst && move1.special == move2.special;
+    }
+
+    static int pieceValue(char piece) {
+        switch (piece) {
+            case 'P':
+            case 'p':
+                return 1;
+            case 'N':
+            case 'n':
+            case 'B':
+            case 'b':
+                return 3;
+            case 'R':
+            case 'r':
+                return 5;
+            case 'Q':
+            case 'q':
+                return 9;
+        }
+        return 0;
+    }
+
+    static int promotionGain(int special) {
+        switch (special) {
+            case thc::SPECIAL_PROMOTION_QUEEN:
+                return 8;
+            case thc::SPECIAL_PROMOTION_ROOK:
+                return 4;
+            case thc::SPECIAL_PROMOTION_BISHOP:
+            case thc::SPECIAL_PROMOTION_KNIGHT:
+                return 2;
+        }
+        return 0;
+    }
+
+private:
+    enum class Stage {
+        HashMove, Generate, WinningCaptures, Killers, Quiets, LosingCaptures, Remaining, Done
+    };
+
+    // history bonus of quiet move is maxHistoryBonus * history / (history + historyHalfBonus) centipawns
+    constexpr static int maxHistoryBonus = 50;
+    constexpr static int historyHalfBonus = 64;
+
+    // splits legal moves into winning captures, quiets and losing captures (in this order), scores captures
+    void generate() {
+        thc::MOVELIST generated;
+        position.genLegalMoves(&generated);
+        moves.count = 0;
+        if (!ordering) {
+            for (int i = 0; i < generated.count; i++) {
+                if (!sameMove(generated.moves[i], hashMove)) {
+                    moves.moves[moves.count++] = generated.moves[i];
+                }
+            }
+            return;
+        }
+
+        std::array<thc::Move, MAXMOVES> quiets;
+        std::array<thc::Move, MAXMOVES> losingCaptures;
+        std::array<int, MAXMOVES> losingScores;
+        int quietsCount = 0;
+        int losingCapturesCount = 0;
+        for (int i = 0; i < generated.count; i++) {
+            auto &move = generated.moves[i];
+            if (sameMove(move, hashMove)) {
+                continue;
+            }
+            if (isQuiet(move)) {
+                quiets[quietsCount++] = move;
+                continue;
+            }
+            // MVV-LVA, capture of less valuable piece (without promotion) waits until quiet moves were tried
+            int gain = pieceValue(char(move.capture)) + promotionGain(move.special);
+            int attacker = pieceValue(board.squares[move.src]);
+            int score = gain * 10 - attacker;
+            if (gain >= attacker) {
+                scores[moves.count] = score;
+                moves.moves[moves.count++] = move;
+            } else {
+                losingScores[losingCapturesCount] = score;
+                losingCaptures[losingCapturesCount++] = move;
+            }
+        }
+        winningCapturesEnd = moves.count;
+        quietsBegin = moves.count;
+        for (int i = 0; i < quietsCount; i++) {
+            moves.moves[moves.count++] = quiets[i];
+        }
+        quietsEnd = moves.count;
+        losingCapturesBegin = moves.count;
+        for (int i = 0; i < losingCapturesCount; i++) {
+            scores[moves.count] = losingScores[i];
+            moves.moves[moves.count++] = losingCaptures[i];
+        }
+    }
+
+    // killer or counter move is taken only when it was generated in this position and not searched yet
+    bool takeQuiet(thc::Move candidate) {
+        if (!candidate.Valid() || sameMove(candidate, hashMove)) {
+            return false;
+        }
+        for (int i = quietsBegin; i < quietsEnd; i++) {
+            if (sameMove(moves.moves[i], candidate)) {
+                std::swap(moves.moves[i], moves.moves[quietsBegin]);
+                quietsBegin++;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void scoreQuiets() {
+        for (int i = quietsBegin; i < quietsEnd; i++) {
+            scores[i] = quietMoveWeight(moves.moves[i]);
+        }
+    }
+
+    // selection sort step: best move of [begin, end) is swapped to begin
+    int pickBest(int begin, int end) {
+        int best = begin;
+        for (int i = begin + 1; i < end; i++) {
+            if (scores[i] > scores[best]) {
+                best = i;
+            }
+        }
+        std::swap(moves.moves[begin], moves.moves[best]);
+        std::swap(scores[begin], scores[best]);
+        return begin;
+    }
+
+    // approximate value of quiet move in centipawns: getting closer to kings, piece square table difference and
+    // history
+    int quietMoveWeight(const thc::Move &move) const {
+        int val = 0;
+        thc::Square kingSquare;
+        thc::Square myKingSquare;
+        if (board.WhiteToPlay()) {
+            kingSquare = board.bking_square;
+            myKingSquare = board.wking_square;
+        } else {
+            kingSquare = board.wking_square;
+            myKingSquare = board.bking_square;
+        }
+        constexpr static std::array<int, 8> squareOffsets = {-9, -8, -7, -1, 1, 7, 8, 9};
+        for (auto offset: squareOffsets) {
+            if (move.dst == kingSquare + offset) {
+                val += 10;
+            }
+            if (move.src == kingSquare + offset) {
+                val -= 10;
+            }
+            if (move.dst == myKingSquare + offset) {
+                val += 10 / 2;
+            }
+            if (move.src == myKingSquare + offset) {
+                val -= 10 / 2;
+            }
+        }
+
+        // the same centipawn tables as evaluation, material of the piece cancels out
+        int piece = BitboardPosition::pieceIndex(board.squares[move.src]);
+        val += pieceSquareValues[piece][move.dst] - pieceSquareValues[piece][move.src];
+
+        int moveHistory = history[move.src][move.dst];
+        val += maxHistoryBonus * moveHistory / (moveHistory + historyHalfBonus);
+        return val;
+    }
+
+    thc::ChessRules &board;
+    BitboardPosition &position;
+    thc::Move hashMove;
+    thc::Move killers[2];
+    thc::Move counterMove;
+    const History &history;
+    bool ordering;
+
+    Stage stage = Stage::HashMove;
+    thc::MOVELIST moves;
+    std::array<int, MAXMOVES> scores;
+    int current = 0;
+    int winningCapturesEnd = 0;
+    int quietsBegin = 0;
+    int quietsEnd = 0;
+    int losingCapturesBegin = 0;
+    int killerIndex = 0;
+};
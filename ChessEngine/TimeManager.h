@@ -0,0 +1,99 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+
+// Decides how long one search may take. Soft limit is the time we would like to use, iterative deepening does not
+// start new iteration after it. Hard limit stops search in the middle of iteration, it is never above the clock.
+class TimeManager {
+public:
+    constexpr static int defaultMoveTimeMs = 3'000;
+
+    // time kept on the clock for communication and process overhead
+    constexpr static int moveOverheadMs = 50;
+
+    // same fixed time for every move, 0 means no limit
+    void setMoveTime(int moveTimeMs) {
+        softLimitMs = moveTimeMs;
+        hardLimitMs = moveTimeMs;
+    }
+
+    // limits from game clock, movesToGo = 0 means rest of the game (sudden death)
+    void setClock(int remainingMs, int incrementMs, int movesToGo) {
+        int available = std::max(remainingMs - moveOverheadMs, 1);
+        int moves = movesToGo > 0 ? std::min(movesToGo, maxMovesToGo) : expectedMovesToGo;
+        hardLimitMs = moves == 1 ? available : std::min(available, available / moves * 3 + incrementMs);
+        softLimitMs = std::min(available / moves + incrementMs * 3 / 4, hardLimitMs);
+        softLimitMs = std::max(softLimitMs, 1);
+        hardLimitMs = std::max(hardLimitMs, 1);
+    }
+
+    void start() {
+        startTime = std::chrono::steady_clock::now();
+        lastIterationMs = 0;
+        previousIterationMs = 0;
+        iterationStartMs = 0;
+        unstableIterations = 0;
+    }
+
+    int elapsedMs() const {
+        return int(std::chrono::duration_cast<std::chrono::milliseconds>(
+                std::chrono::steady_clock::now() - startTime).count());
+    }
+
+    bool hardLimitReached() const {
+        return hardLimitMs > 0 && elapsedMs() > hardLimitMs;
+    }
+
+    // called after every finished iteration, bestMoveChanged - it is different than after previous iteration
+    bool startNextIteration(bool bestMoveChanged) {
+        int now = elapsedMs();
+        previousIterationMs = lastIterationMs;
+        lastIterationMs = now - iterationStartMs;
+        iterationStartMs = now;
+        if (hardLimitMs <= 0) {
+            return true;
+        }
+
+        // unstable best move earns more time, stable one slowly gives it back
+        if (bestMoveChanged) {
+            unstableIterations = std::min(unstableIterations + 2, maxUnstableIterations);
+        } else if (unstableIterations > 0) {
+            unstableIterations--;
+        }
+        int softLimit = std::min(softLimitMs + softLimitMs * unstableIterations / 4, hardLimitMs);
+        if (now >= softLimit) {
+            return false;
+        }
+
+        // next iteration is expected to take branching factor times longer than the last one
+        float branchingFactor = defaultBranchingFactor;
+        if (previousIterationMs > 0 && lastIterationMs > 0) {
+            branchingFactor = std::clamp(float(lastIterationMs) / float(previousIterationMs), 1.5f, 8.f);
+        }
+        return now + int(float(lastIterationMs) * branchingFactor) <= hardLimitMs;
+    }
+
+    int getSoftLimitMs() const {
+        return softLimitMs;
+    }
+
+    int getHardLimitMs() const {
+        return hardLimitMs;
+    }
+
+private:
+    constexpr static int expectedMovesToGo = 30;
+    constexpr static int maxMovesToGo = 50;
+    constexpr static int maxUnstableIterations = 4;
+    constexpr static float defaultBranchingFactor = 4.f;
+
+    int softLimitMs = defaultMoveTimeMs;
+    int hardLimitMs = defaultMoveTimeMs;
+
+    std::chrono::time_point<std::chrono::steady_clock> startTime;
+    int iterationStartMs = 0;
+    int lastIterationMs = 0;
+    int previousIterationMs = 0;
+    int unstableIterations = 0;
+};
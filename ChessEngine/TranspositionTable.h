@@ -0,0 +1,170 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include "chess_rules/thc.h"
+
+enum class HashFlag : uint8_t {
+    Exact, Alpha, Beta
+};
+
+struct HashEntry {
+    int remainingDepth;
+    int16_t evaluation; // centipawns, mate scores are counted from the stored node
+    HashFlag hashFlag;
+    thc::Move bestMove; // capture field is not stored, it is always ' '
+};
+
+// Fixed size table of cache line sized buckets (number of buckets is a power of two).
+// Every slot is a pair of 64 bit words: packed data and key ^ data. Torn writes from concurrent searches
+// make the xor check fail on probe, so no locks are needed.
+class TranspositionTable {
+public:
+    constexpr static size_t defaultSizeMb = 64;
+
+    explicit TranspositionTable(size_t sizeMb = defaultSizeMb) {
+        resize(sizeMb);
+    }
+
+    void resize(size_t sizeMb) {
+        size_t bucketsLimit = std::max<size_t>(sizeMb * 1024 * 1024 / sizeof(Bucket), 1);
+        bucketsCount = 1;
+        while (bucketsCount * 2 <= bucketsLimit) {
+            bucketsCount *= 2;
+        }
+        buckets = std::make_unique<Bucket[]>(bucketsCount);
+        generation = 0;
+    }
+
+    void clear() {
+        for (size_t i = 0; i < bucketsCount; i++) {
+            for (auto &slot: buckets[i].slots) {
+                slot.keyXorData.store(0, std::memory_order_relaxed);
+                slot.data.store(0, std::memory_order_relaxed);
+            }
+        }
+        generation = 0;
+    }
+
+    // entries from previous searches are replaced first
+    void newSearch() {
+        generation = (generation + 1) & generationMask;
+    }
+
+    size_t sizeMb() const {
+        return bucketsCount * sizeof(Bucket) / (1024 * 1024);
+    }
+
+    bool probe(uint64_t key, HashEntry &entry) const {
+        const Bucket &bucket = buckets[key & (bucketsCount - 1)];
+        for (const auto &slot: bucket.slots) {
+            uint64_t data = slot.data.load(std::memory_order_relaxed);
+            if ((data & occupiedBit) && (slot.keyXorData.load(std::memory_order_relaxed) ^ data) == key) {
+                entry = unpack(data);
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void store(uint64_t key, int remainingDepth, int evaluation, HashFlag hashFlag, thc::Move bestMove) {
+        Bucket &bucket = buckets[key & (bucketsCount - 1)];
+
+        Slot *victim = nullptr;
+        int victimValue = std::numeric_limits<int>::max();
+        for (int i = 0; i < slotsPerBucket; i++) {
+            Slot &slot = bucket.slots[i];
+            uint64_t data = slot.data.load(std::memory_order_relaxed);
+            if (!(data & occupiedBit)) {
+                victim = &slot;
+                victimValue = std::numeric_limits<int>::min();
+                break;
+            }
+            if ((slot.keyXorData.load(std::memory_order_relaxed) ^ data) == key) {
+                // same position: keep deeper result from current search, unless new one is exact
+                if (remainingDepth < depthOf(data) && hashFlag != HashFlag::Exact &&
+                    generationOf(data) == generation) {
+                    return;
+                }
+                // node without best move (every move failed low, null move cut off) keeps the stored one
+                if (!bestMove.Valid()) {
+                    bestMove = unpackMove(uint16_t(data >> 32));
+                }
+                victim = &slot;
+                victimValue = std::numeric_limits<int>::min();
+                break;
+            }
+            // last slot is the always-replace one, it does not take part in depth-preferred choice
+            if (i < slotsPerBucket - 1) {
+                int value = depthOf(data) - 4 * int((generation - generationOf(data)) & generationMask);
+                if (value < victimValue) {
+                    victimValue = value;
+                    victim = &slot;
+                }
+            }
+        }
+        if (remainingDepth < victimValue) {
+            victim = &bucket.slots[slotsPerBucket - 1];
+        }
+
+        uint64_t data = pack(remainingDepth, evaluation, hashFlag, bestMove);
+        victim->keyXorData.store(key ^ data, std::memory_order_relaxed);
+        victim->data.store(data, std::memory_order_relaxed);
+    }
+
+private:
+    // data layout: evaluation 16 | unused 16 | move 16 | depth 8 | flag 2 | generation 5 | occupied 1
+    constexpr static int slotsPerBucket = 4;
+    constexpr static uint64_t generationMask = 0x1f;
+    constexpr static uint64_t occupiedBit = uint64_t(1) << 63;
+
+    struct Slot {
+        std::atomic<uint64_t> keyXorData{0};
+        std::atomic<uint64_t> data{0};
+    };
+
+    struct alignas(64) Bucket {
+        Slot slots[slotsPerBucket];
+    };
+
+    static uint16_t packMove(thc::Move move) {
+        return uint16_t(move.src) | uint16_t(move.dst) << 6 | uint16_t(move.special) << 12;
+    }
+
+    static thc::Move unpackMove(uint16_t packed) {
+        thc::Move move;
+        move.src = thc::Square(packed & 0x3f);
+        move.dst = thc::Square((packed >> 6) & 0x3f);
+        move.special = thc::SPECIAL(packed >> 12);
+        move.capture = ' ';
+        return move;
+    }
+
+    uint64_t pack(int remainingDepth, int evaluation, HashFlag hashFlag, thc::Move bestMove) const {
+        return uint64_t(uint16_t(int16_t(evaluation))) |
+               uint64_t(packMove(bestMove)) << 32 |
+               uint64_t(uint8_t(int8_t(remainingDepth))) << 48 |
+               uint64_t(hashFlag) << 56 |
+               (generation & generationMask) << 58 |
+               occupiedBit;
+    }
+
+    static int depthOf(uint64_t data) {
+        return int8_t(uint8_t(data >> 48));
+    }
+
+    static uint64_t generationOf(uint64_t data) {
+        return (data >> 58) & generationMask;
+    }
+
+    static HashEntry unpack(uint64_t data) {
+        return {depthOf(data), int16_t(uint16_t(data)), HashFlag((data >> 56) & 0x3), unpackMove(uint16_t(data >> 32))};
+    }
+
+    std::unique_ptr<Bucket[]> buckets;
+    size_t bucketsCount = 0;
+    uint64_t generation = 0;
+};
@@ -843,6 +843,38 @@ static uint64_t hash64_lookup[64]['r'-'B'+1] =
     }
 };
 
+// Keys for the rest of the position state, xor-ed into the 64 bit hash so
+//  that positions differing only in side to move, castling rights or en
+//  passant target get different hashes
+static uint64_t hash64_black_to_move = 0x07c3e62447ce57e9;
+
+static uint64_t hash64_castling_lookup[4] =     // wking, wqueen, bking, bqueen
+{
+    0x2ec746997017125e, 0x1f1d1f01a9d9a510, 0xe46893867c089f4e, 0x86056a0acb0b79a2
+};
+
+static uint64_t hash64_enpassant_lookup[8] =    // indexed by file of en passant target
+{
+    0x87cfffacf078f425, 0xc0df8eb985855a47, 0xf13a2d6e8e1ae976, 0xdb0af0c78dab8a6c,
+    0x964dc0c2546e2301, 0x7a451e772d22bf79, 0xfa8c2e87ecdc92f9, 0x6598d69183535922
+};
+
+// Castling rights (bit per hash64_castling_lookup entry) lost by a move
+//  from or to a square
+static unsigned int hash64_castling_lost( Square sq )
+{
+    switch( sq )
+    {
+        case e1:    return 1|2;
+        case h1:    return 1;
+        case a1:    return 2;
+        case e8:    return 4|8;
+        case h8:    return 4;
+        case a8:    return 8;
+        default:    return 0;
+    }
+}
+
 
 /****************************************************************************
  * ChessPosition.cpp Chess classes - Representation of the position on the board
@@ -1936,6 +1968,36 @@ uint64_t ChessPosition::Hash64Calculate()
             c = 'a';
         hash ^= hash64_lookup[i][c-'B'];
     }
+    return hash ^ Hash64StateKey();
+}
+
+/****************************************************************************
+ * Side to move, castling and en passant part of the 64 bit hash
+ ****************************************************************************/
+uint64_t ChessPosition::Hash64StateKey() const
+{
+    uint64_t hash = white ? 0 : hash64_black_to_move;
+    if( wking_allowed() )
+        hash ^= hash64_castling_lookup[0];
+    if( wqueen_allowed() )
+        hash ^= hash64_castling_lookup[1];
+    if( bking_allowed() )
+        hash ^= hash64_castling_lookup[2];
+    if( bqueen_allowed() )
+        hash ^= hash64_castling_lookup[3];
+    if( enpassant_target != SQUARE_INVALID )
+        hash ^= hash64_enpassant_lookup[FILE(enpassant_target)-'a'];
+    return hash;
+}
+
+/****************************************************************************
+ * Incremental hash value update for null move (64 bit version)
+ ****************************************************************************/
+uint64_t ChessPosition::Hash64UpdateNullMove( uint64_t hash_in ) const
+{
+    uint64_t hash = hash_in ^ hash64_black_to_move;
+    if( enpassant_target != SQUARE_INVALID )
+        hash ^= hash64_enpassant_lookup[FILE(enpassant_target)-'a'];
     return hash;
 }
 
@@ -1944,7 +2006,21 @@ uint64_t ChessPosition::Hash64Calculate()
  ****************************************************************************/
 uint64_t ChessPosition::Hash64Update( uint64_t hash_in, Move move )
 {
-    uint64_t hash = hash_in;
+    uint64_t hash = hash_in ^ hash64_black_to_move;
+
+    // Castling rights and en passant target, position is still before move
+    unsigned int castling = (wking_allowed()?1:0) | (wqueen_allowed()?2:0) |
+                            (bking_allowed()?4:0) | (bqueen_allowed()?8:0);
+    unsigned int lost = castling & (hash64_castling_lost(move.src) | hash64_castling_lost(move.dst));
+    for( int i=0; lost; i++, lost>>=1 )
+    {
+        if( lost & 1 )
+            hash ^= hash64_castling_lookup[i];
+    }
+    if( enpassant_target != SQUARE_INVALID )
+        hash ^= hash64_enpassant_lookup[FILE(enpassant_target)-'a'];
+    if( move.special==SPECIAL_WPAWN_2SQUARES || move.special==SPECIAL_BPAWN_2SQUARES )
+        hash ^= hash64_enpassant_lookup[FILE(move.dst)-'a'];
     switch( move.special )
     {
         default:
@@ -3263,6 +3339,25 @@ void ChessRules::PushMove( Move& m )
     Toggle();
 }
 
+/****************************************************************************
+ * Pass the turn (null move)
+ ****************************************************************************/
+void ChessRules::PushNullMove()
+{
+    DETAIL_PUSH;
+    enpassant_target = SQUARE_INVALID;
+    Toggle();
+}
+
+/****************************************************************************
+ * Undo a null move
+ ****************************************************************************/
+void ChessRules::PopNullMove()
+{
+    DETAIL_POP;
+    Toggle();
+}
+
 /****************************************************************************
  * Undo a move
  ****************************************************************************/
@@ -21,6 +21,7 @@
  */
 
 #include <stddef.h>
+#include <string.h>
 #include <string>
 #include <vector>
 /****************************************************************************
@@ -206,7 +207,7 @@ public:
     // Use these sparingly when you need to specifically mark
     //  a move as not yet set up (defined when we got rid of
     //  16 bit FMOVEs, we could always set and test 0 with those)
-    void Invalid()  { src=a8; dst=a8; }
+    void Invalid()  { src=a8; dst=a8; special=NOT_SPECIAL; capture=' '; }
     bool Valid()    { return src!=a8 || dst!=a8; }
 
     // Read natural string move eg "Nf3"
@@ -334,7 +335,7 @@ public:
     void Init()
     {
         white = true;
-        strcpy_s( squares, sizeof(squares),
+        memcpy( squares,
            "rnbqkbnr"
            "pppppppp"
            "        "
@@ -342,7 +343,7 @@ public:
            "        "
            "        "
            "PPPPPPPP"
-           "RNBQKBNR" );
+           "RNBQKBNR", sizeof(squares) );
         enpassant_target = SQUARE_INVALID;
         wking  = true;
         wqueen = true;
@@ -482,12 +483,21 @@ public:
     // Incremental hash value update
     uint32_t HashUpdate( uint32_t hash_in, Move move );
 
-    // Calculate a hash value for position (64 bit version)
+    // Calculate a hash value for position (64 bit version, includes side to
+    //  move, castling rights and en passant target)
     uint64_t Hash64Calculate();
 
-    // Incremental hash value update (64 bit version)
+    // Incremental hash value update (64 bit version), call before the move
+    //  is played
     uint64_t Hash64Update( uint64_t hash_in, Move move );
 
+    // Side to move, castling and en passant part of the 64 bit hash
+    uint64_t Hash64StateKey() const;
+
+    // Incremental hash value update for null move (only side to move and
+    //  en passant target change), call before the null move is played
+    uint64_t Hash64UpdateNullMove( uint64_t hash_in ) const;
+
     // Whos turn is it anyway
     inline bool WhiteToPlay() const { return white; }
     void Toggle() { white = !white; }
@@ -610,6 +620,13 @@ public:
     // Undo a move
     void PopMove( Move& m );
 
+    // Pass the turn to the other side (null move, used for pruning in
+    //  search), it is not legal in chess, so don't play it in real game
+    void PushNullMove();
+
+    // Undo a null move
+    void PopNullMove();
+
     // Test fundamental internal assumptions and operations
     void TestInternals();
 
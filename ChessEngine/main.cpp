@@ -1,6 +1,7 @@
 #include <iostream>
 #include <cstring>
 #include <optional>
+#include <cmath>
 
 #include "ChessBoardWeights.h"
 #include "MinMax.h"
@@ -15,105 +16,139 @@
 # define WINDOWS
 #endif
 
-const float AROUND_KING_VALUE = 0.1f;
-
-float ifAroundKing(int kingsPosition, int currentPosition, bool white) {
-    if (kingsPosition - 1 == currentPosition || kingsPosition + 1 == currentPosition ||
-        kingsPosition + 8 == currentPosition || kingsPosition - 8 == currentPosition ||
-        kingsPosition - 9 == currentPosition || kingsPosition + 9 == currentPosition ||
-        kingsPosition - 7 == currentPosition || kingsPosition + 7 == currentPosition) {
-        if (white) {
-            return AROUND_KING_VALUE;
-        } else {
-            return (-1) * AROUND_KING_VALUE;
-        }
-    } else {
-        return 0.0;
-    }
+const int AROUND_KING_VALUE = 10;
+
+// centipawns, positive is good for white
+int evaluate(const BitboardPosition &position) {
+    // material and piece square tables are summed by BitboardPosition on every move
+    int val = position.pieceSquareScore(true) - position.pieceSquareScore(false);
+    // king safety: squares next to opponent's king attacked by side to move, next to its own king defended by it
+    // (divided by two because defending is less fun)
+    bool white = position.whiteToPlay();
+    int attacking = position.attackCount(BitboardAttacks::king(position.kingSquare(!white)), white);
+    int defending = position.attackCount(BitboardAttacks::king(position.kingSquare(white)), white);
+    int kingSafety = AROUND_KING_VALUE * attacking + AROUND_KING_VALUE * defending / 2;
+    val += white ? kingSafety : -kingSafety;
+    return val;
 }
 
-float evaluate(thc::ChessRules &board) {
-    static constexpr float boardPositionWeightDivisor = 300.f;
-    float val = 0.f;
-    for (int i = 0; i < 64; i++) {
-        switch (board.squares[i]) {
-            case 'P':
-                val += 1;
-                val += pawnsOnBoardPositions[i] / boardPositionWeightDivisor;
-                break;
-            case 'R':
-                val += 5;
-                val += rookOnBoardPositions[i] / boardPositionWeightDivisor;
-                break;
-            case 'N':
-                val += 3;
-                val += knightsOnBoardPositions[i] / boardPositionWeightDivisor;
-                break;
-            case 'B':
-                val += 3;
-                val += bishopsOnBoardPositions[i] / boardPositionWeightDivisor;
-                break;
-            case 'Q':
-                val += 9;
-                val += queenOnBoardPositions[i] / boardPositionWeightDivisor;
-                break;
-            case 'K':
-                val += kingOnBoardPositions[i] / boardPositionWeightDivisor;
-                break;
-
-                // black
-            case 'p':
-                val -= 1;
-                val -= pawnsOnBoardPositions[63 - i] / boardPositionWeightDivisor;
-                break;
-            case 'r':
-                val -= 5;
-                val -= rookOnBoardPositions[63 - i] / boardPositionWeightDivisor;
-                break;
-            case 'n':
-                val -= 3;
-                val -= knightsOnBoardPositions[63 - i] / boardPositionWeightDivisor;
-                break;
-            case 'b':
-                val -= 3;
-                val -= bishopsOnBoardPositions[63 - i] / boardPositionWeightDivisor;
-                break;
-            case 'q':
-                val -= 9;
-                val -= queenOnBoardPositions[63 - i] / boardPositionWeightDivisor;
-                break;
-            case 'k':
-                val -= kingOnBoardPositions[63 - i] / boardPositionWeightDivisor;
-                break;
-        }
+// evaluate as a type, so search calls it directly instead of through std::function
+struct Evaluation {
+    int operator()(const BitboardPosition &position) const {
+        return evaluate(position);
     }
-    static thc::MOVELIST moveList = thc::MOVELIST();
-    board.GenLegalMoveList(&moveList);
-    for (int i = 0; i < moveList.count; i++) {
-        auto move = moveList.moves[i];
-        //attacking opponents king
-        val += ifAroundKing(board.WhiteToPlay() ? board.bking_square : board.wking_square, move.dst,
-                            board.WhiteToPlay());
-        //defending my king
-        // divide by two because defending is less fun
-        val += ifAroundKing(board.WhiteToPlay() ? board.wking_square : board.bking_square, move.dst,
-                            board.WhiteToPlay()) / 2.f;
+};
+
+using Engine = MinMax<Evaluation>;
+
+// evaluation returned to Python is in pawns, mate is +-1000 (for white, for black)
+float evaluationInPawns(Engine::Score score) {
+    if (Engine::isMate(score)) {
+        return score > 0 ? 1000.f : -1000.f;
     }
-    return val;
+    return float(score) / 100.f;
 }
 
-extern "C" {
 #ifdef WINDOWS
-__declspec(dllexport) float run(const char *fenInput, char moveOutput[6]) {
+# define ENGINE_API __declspec(dllexport)
 #else
-    float run(const char *fenInput, char moveOutput[6]) {
+# define ENGINE_API
 #endif
-    MinMax minMax(30, evaluate);
+
+constexpr int engineMaxDepth = 30;
+
+// move written by search of invalid FEN (not read by thc or without king of either side), evaluation is
+// invalidPositionEvaluation
+constexpr const char *invalidPositionMove = "0000";
+constexpr float invalidPositionEvaluation = 10000.f;
+
+bool readPosition(const char *fen, thc::ChessRules &board) {
+    return board.Forsyth(fen) && BitboardPosition::hasBothKings(board);
+}
+
+extern "C" {
+// engine handle keeps transposition table and game history alive between moves
+ENGINE_API void *engine_create(size_t hashSizeMb) {
+    return new Engine(engineMaxDepth, Evaluation{}, hashSizeMb);
+}
+
+// clears transposition table, returns its size in MB after rounding down to power of two
+ENGINE_API size_t engine_set_hash_size(void *engine, size_t hashSizeMb) {
+    auto *minMax = static_cast<Engine *>(engine);
+    minMax->setHashSize(hashSizeMb);
+    return minMax->getHashSizeMb();
+}
+
+ENGINE_API void engine_set_threads(void *engine, int threads) {
+    static_cast<Engine *>(engine)->setThreads(threads);
+}
+
+// 0 - lazy SMP, 1 - young brothers wait
+ENGINE_API void engine_set_parallel_mode(void *engine, int mode) {
+    static_cast<Engine *>(engine)->setParallelMode(mode == 1 ? Engine::ParallelMode::Ybwc
+                                                             : Engine::ParallelMode::LazySmp);
+}
+
+ENGINE_API void engine_set_null_move_pruning(void *engine, int enabled) {
+    static_cast<Engine *>(engine)->setNullMovePruning(enabled != 0);
+}
+
+ENGINE_API void engine_set_late_move_reductions(void *engine, int enabled) {
+    static_cast<Engine *>(engine)->setLateMoveReductions(enabled != 0);
+}
+
+// plies added by every iteration of iterative deepening, default 1; returns 0 (step not changed) when plies < 1
+ENGINE_API int engine_set_depth_step(void *engine, int plies) {
+    return static_cast<Engine *>(engine)->setDepthStep(plies) ? 1 : 0;
+}
+
+// search time limit in ms, 0 - no limit
+ENGINE_API void engine_set_time_limit(void *engine, int timeLimitMs) {
+    static_cast<Engine *>(engine)->setTimeLimit(timeLimitMs);
+}
+
+// next engine_search takes its time from game clock (all in ms, movesToGo 0 - rest of the game)
+ENGINE_API void engine_set_clock(void *engine, int remainingMs, int incrementMs, int movesToGo) {
+    static_cast<Engine *>(engine)->setClock(remainingMs, incrementMs, movesToGo);
+}
+
+// aborts engine_search running in other thread, it returns best move found so far
+ENGINE_API void engine_stop(void *engine) {
+    static_cast<Engine *>(engine)->stop();
+}
+
+ENGINE_API void engine_new_game(void *engine) {
+    static_cast<Engine *>(engine)->reset();
+}
+
+// writes best move (UCI) and returns evaluation in pawns; invalid FEN gives invalidPositionMove and
+// invalidPositionEvaluation
+ENGINE_API float engine_search(void *engine, const char *fenInput, char moveOutput[6]) {
     thc::ChessRules board;
-    board.Forsyth(fenInput);
+    if (!readPosition(fenInput, board)) {
+        strcpy(moveOutput, invalidPositionMove);
+        return invalidPositionEvaluation;
+    }
+    auto[move, eval] = static_cast<Engine *>(engine)->run(board);
+    strcpy(moveOutput, move.TerseOut().c_str());
+    return evaluationInPawns(eval);
+}
+
+ENGINE_API void engine_destroy(void *engine) {
+    delete static_cast<Engine *>(engine);
+}
+
+// one-shot search, builds new engine on every call
+ENGINE_API float run(const char *fenInput, char moveOutput[6]) {
+    thc::ChessRules board;
+    if (!readPosition(fenInput, board)) {
+        strcpy(moveOutput, invalidPositionMove);
+        return invalidPositionEvaluation;
+    }
+    Engine minMax(engineMaxDepth, Evaluation{});
     auto[move, eval] = minMax.run(board);
     strcpy(moveOutput, move.TerseOut().c_str());
-    return eval;
+    return evaluationInPawns(eval);
 }
 }
 
@@ -135,44 +170,58 @@ void test4();
 
 void test5();
 
+void test6();
+
+void test7();
+
+void test8();
+
+void test9();
+
+void test10();
+
+void test11();
+
+void test12();
+
 int main() {
     test1();
 }
 
-void test1() {
-    std::vector<std::string> testPositions = {
-            "1k1r4/pp1b1R2/3q2pp/4p3/2B5/4Q3/PPP2B2/2K5 b - - 1 1",
-            "3r1k2/4npp1/1ppr3p/p6P/P2PPPP1/1NR5/5K2/2R5 w - - 1 1",
-            "2q1rr1k/3bbnnp/p2p1pp1/2pPp3/PpP1P1P1/1P2BNNP/2BQ1PRK/7R b - - 1 1",
-            "rnbqkb1r/p3pppp/1p6/2ppP3/3N4/2P5/PPP1QPPP/R1B1KB1R w KQkq - 1 1",
-            "r1b2rk1/2q1b1pp/p2ppn2/1p6/3QP3/1BN1B3/PPP3PP/R4RK1 w - - 1 1",
-            "2r3k1/pppR1pp1/4p3/4P1P1/5P2/1P4K1/P1P5/8 w - - 1 1",
-            "1nk1r1r1/pp2n1pp/4p3/q2pPp1N/b1pP1P2/B1P2R2/2P1B1PP/R2Q2K1 w - - 1 1",
-            "4b3/p3kp2/6p1/3pP2p/2pP1P2/4K1P1/P3N2P/8 w - - 1 1",
-            "2kr1bnr/pbpq4/2n1pp2/3p3p/3P1P1B/2N2N1Q/PPP3PP/2KR1B1R w - - 1 1",
-            "3rr1k1/pp3pp1/1qn2np1/8/3p4/PP1R1P2/2P1NQPP/R1B3K1 b - - 1 1",
-            "2r1nrk1/p2q1ppp/bp1p4/n1pPp3/P1P1P3/2PBB1N1/4QPPP/R4RK1 w - - 1 1",
-            "r3r1k1/ppqb1ppp/8/4p1NQ/8/2P5/PP3PPP/R3R1K1 b - - 1 1",
-            "r2q1rk1/4bppp/p2p4/2pP4/3pP3/3Q4/PP1B1PPP/R3R1K1 w - - 1 1",
-            "rnb2r1k/pp2p2p/2pp2p1/q2P1p2/8/1Pb2NP1/PB2PPBP/R2Q1RK1 w - - 1 1",
-            "2r3k1/1p2q1pp/2b1pr2/p1pp4/6Q1/1P1PP1R1/P1PN2PP/5RK1 w - - 1 1",
-            "r1bqkb1r/4npp1/p1p4p/1p1pP1B1/8/1B6/PPPN1PPP/R2Q1RK1 w kq - 1 1",
-            "r2q1rk1/1ppnbppp/p2p1nb1/3Pp3/2P1P1P1/2N2N1P/PPB1QP2/R1B2RK1 b - - 1 1",
-            "r1bq1rk1/pp2ppbp/2np2p1/2n5/P3PP2/N1P2N2/1PB3PP/R1B1QRK1 b - - 1 1",
-            "3rr3/2pq2pk/p2p1pnp/8/2QBPP2/1P6/P5PP/4RRK1 b - - 1 1",
-            "r4k2/pb2bp1r/1p1qp2p/3pNp2/3P1P2/2N3P1/PPP1Q2P/2KRR3 w - - 1 1",
-            "3rn2k/ppb2rpp/2ppqp2/5N2/2P1P3/1P5Q/PB3PPP/3RR1K1 w - - 1 1",
-            "2r2rk1/1bqnbpp1/1p1ppn1p/pP6/N1P1P3/P2B1N1P/1B2QPP1/R2R2K1 b - - 1 1",
-            "r1bqk2r/pp2bppp/2p5/3pP3/P2Q1P2/2N1B3/1PP3PP/R4RK1 b kq - 1 1",
-            "r2qnrnk/p2b2b1/1p1p2pp/2pPpp2/1PP1P3/PRNBB3/3QNPPP/5RK1 w - - 1 1"
-    };
+const std::vector<std::string> test1Positions = {
+        "1k1r4/pp1b1R2/3q2pp/4p3/2B5/4Q3/PPP2B2/2K5 b - - 1 1",
+        "3r1k2/4npp1/1ppr3p/p6P/P2PPPP1/1NR5/5K2/2R5 w - - 1 1",
+        "2q1rr1k/3bbnnp/p2p1pp1/2pPp3/PpP1P1P1/1P2BNNP/2BQ1PRK/7R b - - 1 1",
+        "rnbqkb1r/p3pppp/1p6/2ppP3/3N4/2P5/PPP1QPPP/R1B1KB1R w KQkq - 1 1",
+        "r1b2rk1/2q1b1pp/p2ppn2/1p6/3QP3/1BN1B3/PPP3PP/R4RK1 w - - 1 1",
+        "2r3k1/pppR1pp1/4p3/4P1P1/5P2/1P4K1/P1P5/8 w - - 1 1",
+        "1nk1r1r1/pp2n1pp/4p3/q2pPp1N/b1pP1P2/B1P2R2/2P1B1PP/R2Q2K1 w - - 1 1",
+        "4b3/p3kp2/6p1/3pP2p/2pP1P2/4K1P1/P3N2P/8 w - - 1 1",
+        "2kr1bnr/pbpq4/2n1pp2/3p3p/3P1P1B/2N2N1Q/PPP3PP/2KR1B1R w - - 1 1",
+        "3rr1k1/pp3pp1/1qn2np1/8/3p4/PP1R1P2/2P1NQPP/R1B3K1 b - - 1 1",
+        "2r1nrk1/p2q1ppp/bp1p4/n1pPp3/P1P1P3/2PBB1N1/4QPPP/R4RK1 w - - 1 1",
+        "r3r1k1/ppqb1ppp/8/4p1NQ/8/2P5/PP3PPP/R3R1K1 b - - 1 1",
+        "r2q1rk1/4bppp/p2p4/2pP4/3pP3/3Q4/PP1B1PPP/R3R1K1 w - - 1 1",
+        "rnb2r1k/pp2p2p/2pp2p1/q2P1p2/8/1Pb2NP1/PB2PPBP/R2Q1RK1 w - - 1 1",
+        "2r3k1/1p2q1pp/2b1pr2/p1pp4/6Q1/1P1PP1R1/P1PN2PP/5RK1 w - - 1 1",
+        "r1bqkb1r/4npp1/p1p4p/1p1pP1B1/8/1B6/PPPN1PPP/R2Q1RK1 w kq - 1 1",
+        "r2q1rk1/1ppnbppp/p2p1nb1/3Pp3/2P1P1P1/2N2N1P/PPB1QP2/R1B2RK1 b - - 1 1",
+        "r1bq1rk1/pp2ppbp/2np2p1/2n5/P3PP2/N1P2N2/1PB3PP/R1B1QRK1 b - - 1 1",
+        "3rr3/2pq2pk/p2p1pnp/8/2QBPP2/1P6/P5PP/4RRK1 b - - 1 1",
+        "r4k2/pb2bp1r/1p1qp2p/3pNp2/3P1P2/2N3P1/PPP1Q2P/2KRR3 w - - 1 1",
+        "3rn2k/ppb2rpp/2ppqp2/5N2/2P1P3/1P5Q/PB3PPP/3RR1K1 w - - 1 1",
+        "2r2rk1/1bqnbpp1/1p1ppn1p/pP6/N1P1P3/P2B1N1P/1B2QPP1/R2R2K1 b - - 1 1",
+        "r1bqk2r/pp2bppp/2p5/3pP3/P2Q1P2/2N1B3/1PP3PP/R4RK1 b kq - 1 1",
+        "r2qnrnk/p2b2b1/1p1p2pp/2pPpp2/1PP1P3/PRNBB3/3QNPPP/5RK1 w - - 1 1"
+};
 
-    MinMax minMax(6, evaluate);
+void test1() {
+    Engine minMax(6, Evaluation{});
     thc::ChessRules board;
 
     uint32_t testTime = 0;
 
-    for (const auto &fen: testPositions) {
+    for (const auto &fen: test1Positions) {
         board.Forsyth(fen.c_str());
         minMax.reset();
 
@@ -192,7 +241,7 @@ void test1() {
 }
 
 void test2() {
-    MinMax minMax(5, evaluate);
+    Engine minMax(5, Evaluation{});
     thc::ChessRules board;
     board.Forsyth("2q1rr1k/3bbnnp/p2p1pp1/2pPp3/PpP1P1P1/1P2BNNP/2BQ1PRK/7R b - - 1 1");
     uint32_t testTime = 0;
@@ -258,11 +307,11 @@ void test3() {
     board.PlayMove(move);
     display_position(board);
 
-    MinMax minMax(2, evaluate);
+    Engine minMax(2, Evaluation{});
 
     auto[minMaxBestMove, eval] = minMax.run(board);
     std::cout << "Move: " << minMaxBestMove.TerseOut() << " | Eval: " << eval << "\n";
-    auto evalAfterPlayingMoves = evaluate(board);
+    auto evalAfterPlayingMoves = evaluate(BitboardPosition(board));
     std::cout << "eval: " << eval << " eval after playing moves: " << evalAfterPlayingMoves << "\n";
     display_position(board);
 
@@ -270,7 +319,7 @@ void test3() {
 }
 
 void test4() {
-    MinMax minMax(25, evaluate);
+    Engine minMax(25, Evaluation{});
     thc::ChessRules board;
 
     uint32_t testTime = 0;
@@ -296,7 +345,7 @@ void test4() {
 }
 
 void test5() {
-    MinMax minMax(6, evaluate);
+    Engine minMax(6, Evaluation{});
     thc::ChessRules board;
 
     uint32_t testTime = 0;
@@ -319,4 +368,190 @@ void test5() {
 #ifdef DEBUG_STATS
     minMax.printDebugStats();
 #endif
-}
\ No newline at end of file
+}
+
+// parallel search time to depth on test1 positions, single thread against all hardware threads in both modes
+void test6() {
+    int hardwareThreads = std::max(int(std::thread::hardware_concurrency()), 1);
+    std::array<std::tuple<const char *, int, Engine::ParallelMode>, 3> configurations{{
+            {"single thread", 1, Engine::ParallelMode::LazySmp},
+            {"lazy SMP", hardwareThreads, Engine::ParallelMode::LazySmp},
+            {"YBWC", hardwareThreads, Engine::ParallelMode::Ybwc}
+    }};
+    for (auto[name, threads, mode]: configurations) {
+        Engine minMax(4, Evaluation{});
+        minMax.setTimeLimit(0);
+        minMax.setThreads(threads);
+        minMax.setParallelMode(mode);
+        thc::ChessRules board;
+
+        uint32_t testTime = 0;
+        uint64_t nodes = 0;
+        for (const auto &fen: test1Positions) {
+            board.Forsyth(fen.c_str());
+            minMax.reset();
+
+            auto start = std::chrono::high_resolution_clock::now();
+            minMax.run(board);
+            auto end = std::chrono::high_resolution_clock::now();
+            testTime += std::chrono::duration_cast<std::chrono::milliseconds>(end - start).count();
+            nodes += minMax.getLastSearchNodes();
+        }
+        std::cout << "\n\n" << name << " THREADS: " << threads << " TEST TIME: " << testTime << " ms NODES: " << nodes
+                  << " NODES/S: " << nodes * 1000 / std::max<uint32_t>(testTime, 1) << "\n\n";
+    }
+}
+
+// self play on game clock, engine should never run out of time
+void test7() {
+    Engine minMax(30, Evaluation{});
+    thc::ChessRules board;
+    constexpr int numberOfMovesToPlay = 40;
+    constexpr int incrementMs = 100;
+    std::array<int, 2> clocksMs = {10'000, 10'000};
+
+    for (int i = 0; i < numberOfMovesToPlay; i++) {
+        int &clockMs = clocksMs[board.WhiteToPlay() ? 0 : 1];
+        minMax.setClock(clockMs, incrementMs);
+
+        auto start = std::chrono::steady_clock::now();
+        auto[move, eval] = minMax.run(board);
+        auto end = std::chrono::steady_clock::now();
+        clockMs -= int(std::chrono::duration_cast<std::chrono::milliseconds>(end - start).count());
+        if (clockMs < 0) {
+            std::cout << "\nFLAGGED\n";
+            break;
+        }
+        clockMs += incrementMs;
+        std::cout << "Move: " << move.TerseOut() << " | Eval: " << eval << " | Clocks: " << clocksMs[0] << " "
+                  << clocksMs[1] << "\n";
+
+        thc::TERMINAL evalPos;
+        board.PlayMove(move);
+        board.Evaluate(evalPos);
+        if (evalPos != thc::TERMINAL::NOT_TERMINAL) {
+            break;
+        }
+    }
+}
+
+void test8() {
+    for (int depthStep: {2, 1}) {
+        Engine minMax(30, Evaluation{});
+        minMax.setDepthStep(depthStep);
+        thc::ChessRules board;
+
+        int depthSum = 0;
+        for (const auto &fen: test1Positions) {
+            board.Forsyth(fen.c_str());
+            minMax.reset();
+            minMax.run(board);
+            depthSum += minMax.getLastCompletedDepth();
+        }
+        std::cout << "\n\nDEPTH STEP: " << depthStep << " AVERAGE COMPLETED DEPTH: "
+                  << float(depthSum) / float(test1Positions.size()) << "\n\n";
+    }
+}
+
+void test9() {
+    constexpr int depth = 5;
+    std::array<std::tuple<const char *, bool, bool>, 4> configurations{{
+            {"no pruning", false, false},
+            {"null move", true, false},
+            {"LMR", false, true},
+            {"null move + LMR", true, true}
+    }};
+    for (auto[name, nullMove, lmr]: configurations) {
+        Engine minMax(depth, Evaluation{});
+        minMax.setTimeLimit(0);
+        minMax.setNullMovePruning(nullMove);
+        minMax.setLateMoveReductions(lmr);
+        thc::ChessRules board;
+
+        uint32_t testTime = 0;
+        double branchingFactorSum = 0.;
+        for (const auto &fen: test1Positions) {
+            board.Forsyth(fen.c_str());
+            minMax.reset();
+
+            auto start = std::chrono::high_resolution_clock::now();
+            minMax.run(board);
+            auto end = std::chrono::high_resolution_clock::now();
+            testTime += std::chrono::duration_cast<std::chrono::milliseconds>(end - start).count();
+            // effective branching factor: number of nodes is about ebf^depth
+            branchingFactorSum += std::pow(double(minMax.getLastSearchNodes()), 1. / depth);
+        }
+        std::cout << "\n\n" << name << " TEST TIME: " << testTime << " ms EFFECTIVE BRANCHING FACTOR: "
+                  << branchingFactorSum / double(test1Positions.size()) << "\n\n";
+    }
+}
+
+void test10() {
+    // mates have to be found in the fewest moves (mate in 1 while longer mates exist), iterative deepening stops
+    // at the depth where the mate was found
+    std::array<std::pair<const char *, int>, 5> positions{{
+            {"6k1/5ppp/8/8/8/8/5PPP/R5K1 w - - 0 1", 1},
+            {"r1bqkb1r/pppp1ppp/2n2n2/4p2Q/2B1P3/8/PPPP1PPP/RNB1K1NR w KQkq - 4 4", 1},
+            {"1k6/8/8/8/8/1r6/r7/7K b - - 0 1", 1},
+            {"k7/8/1K6/8/8/8/8/1Q6 w - - 0 1", 2},
+            {"2k5/8/1K6/8/8/8/8/3R4 w - - 0 1", 2}
+    }};
+    for (auto[fen, mateIn]: positions) {
+        Engine minMax(10, Evaluation{});
+        minMax.setTimeLimit(0);
+        thc::ChessRules board;
+        board.Forsyth(fen);
+
+        std::cout << fen << "\n";
+        auto[move, eval] = minMax.run(board);
+        std::cout << "Move: " << move.TerseOut() << " | Eval: " << eval << " | Mate in: "
+                  << (Engine::isMate(eval) ? Engine::mateInMoves(eval) : 0) << " (expected " << mateIn
+                  << ") | Depth: " << minMax.getLastCompletedDepth() << "\n\n";
+    }
+}
+
+void test11() {
+    // depth step larger than maximum depth still searches maximum depth once, step below 1 is rejected
+    constexpr int maxDepth = 4;
+    Engine minMax(maxDepth, Evaluation{});
+    minMax.setTimeLimit(0);
+    std::cout << "Depth step 0 accepted: " << minMax.setDepthStep(0) << "\n";
+    minMax.setDepthStep(50);
+    thc::ChessRules board;
+
+    for (const auto &fen: test1Positions) {
+        board.Forsyth(fen.c_str());
+        minMax.reset();
+        auto[move, eval] = minMax.run(board);
+        BitboardPosition position(board);
+        std::cout << "Move: " << move.TerseOut() << " | Legal: " << position.legalMove(move) << " | Depth: "
+                  << minMax.getLastCompletedDepth() << " (expected " << maxDepth << ")\n\n";
+    }
+}
+
+void test12() {
+    // fixed depth search of test1 positions without time limit: nodes, time and best moves to compare changes of
+    // move generation, ordering and pruning (same nodes and moves are expected from changes of speed only)
+    constexpr int depth = 5;
+    Engine minMax(depth, Evaluation{});
+    minMax.setTimeLimit(0);
+    thc::ChessRules board;
+
+    uint64_t nodes = 0;
+    std::string moves;
+    auto start = std::chrono::high_resolution_clock::now();
+    for (const auto &fen: test1Positions) {
+        board.Forsyth(fen.c_str());
+        minMax.reset();
+        auto[move, eval] = minMax.run(board);
+        nodes += minMax.getLastSearchNodes();
+        moves += move.TerseOut() + " ";
+    }
+    auto end = std::chrono::high_resolution_clock::now();
+
+    std::cout << "\n\nDEPTH: " << depth << " MOVES: " << moves << "\nNODES: " << nodes << " TEST TIME: "
+              << std::chrono::duration_cast<std::chrono::milliseconds>(end - start).count() << " ms\n\n";
+#ifdef DEBUG_STATS
+    minMax.printDebugStats();
+#endif
+}
@@ -0,0 +1,237 @@
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <atomic>
+#include <thread>
+#include <vector>
+#include <string>
+#include <cstring>
+#include <cstdlib>
+
+#include "BitboardPosition.h"
+
+// Counts leaf nodes of the legal move tree (perft) to check move generators and to measure their speed.
+// Without arguments reference positions are counted and compared with known node counts, exit code is 1 on mismatch,
+// 2 on invalid arguments or FEN.
+
+struct ReferencePosition {
+    const char *fen;
+    std::vector<uint64_t> nodes; // expected nodes of depth 1, 2, ...
+    int defaultDepth; // depth counted by default, about a second with one thread
+};
+
+const std::vector<ReferencePosition> referencePositions = {
+        {"rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1",
+                {20, 400, 8902, 197281, 4865609, 119060324},                6},
+        {"r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+                {48, 2039, 97862, 4085603, 193690690},                      5},
+        {"8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1",
+                {14, 191, 2812, 43238, 674624, 11030083, 178633661},        7},
+        {"r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1",
+                {6, 264, 9467, 422333, 15833292, 706045033},                5},
+        {"rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - 1 8",
+                {44, 1486, 62379, 2103487, 89941194},                       5},
+        {"r4rk1/1pp1qppp/p1np1n2/2b1p1B1/2B1P1b1/P1NP1N2/1PP1QPPP/R4RK1 w - - 0 10",
+                {46, 2079, 89890, 3894594, 164075551, 6923051137},          5}
+};
+
+struct PerftOptions {
+    int depth = -1; // not set: default depth of reference positions, 1 with fen
+    const char *fen = nullptr;
+    bool divide = false;
+    bool bulk = true;
+    bool thcGenerator = false;
+    int threads = int(std::max(std::thread::hardware_concurrency(), 1u));
+};
+
+// bulk: at depth 1 generated moves are counted without making them
+uint64_t perft(BitboardPosition &position, int depth, bool bulk) {
+    if (depth == 0) {
+        return 1;
+    }
+    thc::MOVELIST moveList;
+    position.genLegalMoves(&moveList);
+    if (bulk && depth == 1) {
+        return uint64_t(moveList.count);
+    }
+    uint64_t nodes = 0;
+    for (int i = 0; i < moveList.count; i++) {
+        position.pushMove(moveList.moves[i]);
+        nodes += perft(position, depth - 1, bulk);
+        position.popMove(moveList.moves[i]);
+    }
+    return nodes;
+}
+
+// the same with thc::ChessRules generator, which makes every pseudo legal move to test its legality
+uint64_t perft(thc::ChessRules &board, int depth, bool bulk) {
+    if (depth == 0) {
+        return 1;
+    }
+    thc::MOVELIST moveList;
+    board.GenLegalMoveList(&moveList);
+    if (bulk && depth == 1) {
+        return uint64_t(moveList.count);
+    }
+    uint64_t nodes = 0;
+    for (int i = 0; i < moveList.count; i++) {
+        board.PushMove(moveList.moves[i]);
+        nodes += perft(board, depth - 1, bulk);
+        board.PopMove(moveList.moves[i]);
+    }
+    return nodes;
+}
+
+// root moves are split between threads, every thread counts subtrees of moves it takes on its own copy of position
+// nodes of every root move are returned in order of moves in rootMoves
+std::vector<uint64_t> perftRootMoves(const thc::ChessRules &board, const thc::MOVELIST &rootMoves, int depth,
+                                     const PerftOptions &options) {
+    std::vector<uint64_t> nodes(rootMoves.count, 0);
+    std::atomic<int> nextMove = 0;
+    auto worker = [&]() {
+        thc::ChessRules threadBoard = board;
+        BitboardPosition position(board);
+        for (int i = nextMove++; i < rootMoves.count; i = nextMove++) {
+            thc::Move move = rootMoves.moves[i];
+            if (options.thcGenerator) {
+                threadBoard.PushMove(move);
+                nodes[i] = perft(threadBoard, depth - 1, options.bulk);
+                threadBoard.PopMove(move);
+            } else {
+                position.pushMove(move);
+                nodes[i] = perft(position, depth - 1, options.bulk);
+                position.popMove(move);
+            }
+        }
+    };
+
+    std::vector<std::thread> helpers;
+    for (int i = 1; i < std::min(options.threads, rootMoves.count); i++) {
+        helpers.emplace_back(worker);
+    }
+    worker();
+    for (auto &helper: helpers) {
+        helper.join();
+    }
+    return nodes;
+}
+
+// prints nodes and speed, divide prints nodes after every root move too
+// returns false when fen is not a valid position
+bool runPerft(const char *fen, int depth, const PerftOptions &options, uint64_t &nodes) {
+    nodes = 0;
+    thc::ChessRules board;
+    if (!board.Forsyth(fen)) {
+        std::cout << "Invalid FEN: " << fen << "\n";
+        return false;
+    }
+    if (!BitboardPosition::hasBothKings(board)) {
+        std::cout << "Invalid FEN (every side needs one king): " << fen << "\n";
+        return false;
+    }
+
+    auto start = std::chrono::high_resolution_clock::now();
+    thc::MOVELIST rootMoves;
+    if (options.thcGenerator) {
+        board.GenLegalMoveList(&rootMoves);
+    } else {
+        BitboardPosition(board).genLegalMoves(&rootMoves);
+    }
+    if (depth == 0) {
+        nodes = 1;
+    } else {
+        auto rootNodes = perftRootMoves(board, rootMoves, depth, options);
+        for (int i = 0; i < rootMoves.count; i++) {
+            nodes += rootNodes[i];
+            if (options.divide) {
+                std::cout << rootMoves.moves[i].TerseOut() << ": " << rootNodes[i] << "\n";
+            }
+        }
+    }
+    auto end = std::chrono::high_resolution_clock::now();
+
+    double seconds = std::chrono::duration<double>(end - start).count();
+    std::cout << fen << "\ndepth " << depth << " nodes " << nodes << " time "
+              << std::chrono::duration_cast<std::chrono::milliseconds>(end - start).count() << " ms "
+              << std::fixed << std::setprecision(2) << (seconds > 0. ? double(nodes) / seconds / 1e6 : 0.)
+              << " Mnodes/s" << std::defaultfloat << "\n";
+    return true;
+}
+
+void printUsage() {
+    std::cout << "Usage: perft [options]\n"
+                 "Without --fen reference positions are counted and checked against known node counts.\n"
+                 "  -d, --depth N      depth, 0 counts only the root (default: depth of every reference\n"
+                 "                     position, 1 with --fen)\n"
+                 "  -f, --fen FEN      count this position\n"
+                 "  --divide           print nodes after every root move\n"
+                 "  -t, --threads N    threads, root moves are split between them (default all hardware threads)\n"
+                 "  --no-bulk          make every leaf move instead of counting moves generated at depth 1\n"
+                 "  --thc              thc::ChessRules generator instead of bitboards\n";
+}
+
+bool parseOptions(int argc, char **argv, PerftOptions &options) {
+    for (int i = 1; i < argc; i++) {
+        auto argument = [&](const char *shortName, const char *longName) {
+            return (shortName != nullptr && std::strcmp(argv[i], shortName) == 0) ||
+                   std::strcmp(argv[i], longName) == 0;
+        };
+        bool hasValue = i + 1 < argc;
+        if (argument("-d", "--depth") && hasValue) {
+            options.depth = std::atoi(argv[++i]);
+            if (options.depth < 0) {
+                return false;
+            }
+        } else if (argument("-f", "--fen") && hasValue) {
+            options.fen = argv[++i];
+        } else if (argument("-t", "--threads") && hasValue) {
+            options.threads = std::max(std::atoi(argv[++i]), 1);
+        } else if (argument(nullptr, "--divide")) {
+            options.divide = true;
+        } else if (argument(nullptr, "--no-bulk")) {
+            options.bulk = false;
+        } else if (argument(nullptr, "--thc")) {
+            options.thcGenerator = true;
+        } else {
+            return false;
+        }
+    }
+    return true;
+}
+
+int main(int argc, char **argv) {
+    PerftOptions options;
+    if (!parseOptions(argc, argv, options)) {
+        printUsage();
+        return 2;
+    }
+    std::cout << "Generator: " << (options.thcGenerator ? "thc" : "bitboards") << (options.bulk ? ", bulk" : "")
+              << ", threads: " << options.threads << "\n\n";
+
+    if (options.fen != nullptr) {
+        uint64_t nodes;
+        return runPerft(options.fen, options.depth >= 0 ? options.depth : 1, options, nodes) ? 0 : 2;
+    }
+
+    bool passed = true;
+    uint64_t totalNodes = 0;
+    auto start = std::chrono::high_resolution_clock::now();
+    for (const auto &position: referencePositions) {
+        int depth = options.depth >= 0 ? std::min(options.depth, int(position.nodes.size())) : position.defaultDepth;
+        uint64_t nodes;
+        runPerft(position.fen, depth, options, nodes);
+        uint64_t expected = depth > 0 ? position.nodes[depth - 1] : 1;
+        totalNodes += nodes;
+        if (nodes != expected) {
+            std::cout << "FAILED, expected " << expected << " nodes\n";
+            passed = false;
+        }
+        std::cout << "\n";
+    }
+    auto end = std::chrono::high_resolution_clock::now();
+    double seconds = std::chrono::duration<double>(end - start).count();
+    std::cout << (passed ? "PASSED" : "FAILED") << " total nodes " << totalNodes << " time "
+              << std::chrono::duration_cast<std::chrono::milliseconds>(end - start).count() << " ms "
+              << std::fixed << std::setprecision(2) << double(totalNodes) / seconds / 1e6 << " Mnodes/s\n";
+    return passed ? 0 : 1;
+}
@@ -5,14 +5,33 @@ import ctypes
 class ChessEngine:
     def __init__(self):
         self.engine_lib = ctypes.cdll.LoadLibrary('../ChessEngine/engineDll/ChessEngine.dll')
-        self.run_function = self.engine_lib.run
-        self.run_function.argtypes = [ctypes.c_char_p,
-                                      ctypes.c_char_p]  # first is board fen, second is output buffer for move
-        self.run_function.restype = ctypes.c_float  # return position evaluation
+        self.engine_lib.engine_create.argtypes = [ctypes.c_size_t]  # transposition table size in MB
+        self.engine_lib.engine_create.restype = ctypes.c_void_p
+        self.engine_lib.engine_new_game.argtypes = [ctypes.c_void_p]
+        self.engine_lib.engine_destroy.argtypes = [ctypes.c_void_p]
+        self.search_function = self.engine_lib.engine_search
+        self.search_function.argtypes = [ctypes.c_void_p, ctypes.c_char_p,
+                                         ctypes.c_char_p]  # engine handle, board fen, output buffer for move
+        self.search_function.restype = ctypes.c_float  # return position evaluation
+
+        self.engine = self.engine_lib.engine_create(64)  # kept for the whole game, so search reuses its tables
 
         self.move_char_buffer = ctypes.create_string_buffer(6)  # buffer to save best move to
 
+    # engine_search writes this move (with evaluation 10000) when it cannot read the position
+    INVALID_POSITION_MOVE = "0000"
+
     def run_engine(self, board: chess.Board):
-        evaluation: float = self.run_function(board.fen().encode(), self.move_char_buffer)
+        evaluation: float = self.search_function(self.engine, board.fen().encode(), self.move_char_buffer)
         move_str: str = self.move_char_buffer.value.decode("utf-8")
+        if move_str == self.INVALID_POSITION_MOVE:
+            raise ValueError("engine rejected position: " + board.fen())
         return [chess.Move.from_uci(move_str), evaluation]
+
+    def new_game(self):
+        self.engine_lib.engine_new_game(self.engine)
+
+    def __del__(self):
+        if getattr(self, "engine", None):
+            self.engine_lib.engine_destroy(self.engine)
+            self.engine = None